@@ -0,0 +1,200 @@
+#!/usr/bin/perl -w
+# Run the cplof benchmarks: each is run --warmup times untimed, then --reps
+# times timed. Reports the median, variance and spread of the wall times, the
+# peak RSS and the number of GCs, optionally writes them as JSON (--json) and
+# compares them to JSON from an earlier run (--baseline).
+#
+# Use: bench/run.pl [--cplof <path>] [--warmup <n>] [--reps <n>]
+#                   [--size <bench>=<n>]... [--only <bench>]...
+#                   [--json <file>] [--baseline <file>]
+use strict;
+use File::Basename;
+use File::Temp qw(tempdir);
+use Getopt::Long;
+use JSON::PP;
+use Time::HiRes qw(time);
+
+my $dir = dirname($0);
+
+my $cplof = "cplof/src/cplof";
+my $warmup = 1;
+my $reps = 5;
+my %sizes = ();
+my @only = ();
+my $json;
+my $baseline;
+
+GetOptions(
+    "cplof=s" => \$cplof,
+    "warmup=i" => \$warmup,
+    "reps=i" => \$reps,
+    "size=s" => \%sizes,
+    "only=s" => \@only,
+    "json=s" => \$json,
+    "baseline=s" => \$baseline
+) or die "Use: $0 [--cplof <path>] [--warmup <n>] [--reps <n>] [--size <bench>=<n>]... [--only <bench>]... [--json <file>] [--baseline <file>]\n";
+die "--reps must be at least 1\n" if ($reps < 1);
+
+my $tmp = tempdir(CLEANUP => 1);
+
+# generate Plof source for the parser to chew on: size functions
+sub genParse {
+    my $size = shift;
+    my $file = "$tmp/parse.plof";
+    open(my $fh, ">", $file) or die "$file: $!\n";
+    for (my $i = 0; $i < $size; $i++) {
+        print $fh <<"EOF";
+// function $i
+var f$i = (a, b) {
+    var c = a + b * $i
+    if (c > 10) (
+        return (c - 1)
+    ) else (
+        c = c ~ "$i"
+    )
+    var x
+    [[ a, b, c ]].each (ref x) (
+        Debug.print(x)
+    )
+    c
+}
+
+EOF
+    }
+    close($fh);
+    return ("-c", "-o", "$tmp/parse.psl", $file);
+}
+
+# name, default size, and the arguments to cplof for a size
+my @benches = (
+    [ "startup",     0,    sub { ("$dir/empty.plof") } ],
+    [ "parse",       200,  \&genParse ],
+    [ "binarytrees", 6,    sub { ("$dir/binarytrees.plof", @_) } ],
+    [ "dispatch",    2000, sub { ("$dir/dispatch.plof", @_) } ],
+    [ "strings",     2000, sub { ("$dir/strings.plof", @_) } ],
+    [ "arrays",      5000, sub { ("$dir/arrays.plof", @_) } ],
+    [ "exceptions",  2000, sub { ("$dir/exceptions.plof", @_) } ]
+);
+
+# quote for the shell
+sub shq {
+    my $s = shift;
+    $s =~ s/'/'\\''/g;
+    return "'$s'";
+}
+
+# run cplof once, returning the wall time and its --stats
+sub runOnce {
+    my @args = @_;
+    my $err = "$tmp/stderr";
+    my $cmd = join(" ", map { shq($_) } ($cplof, "--stats", @args)) . " > /dev/null 2> " . shq($err);
+
+    my $start = time();
+    my $ret = system($cmd);
+    my $elapsed = time() - $start;
+
+    my %stats = ();
+    open(my $fh, "<", $err) or die "$err: $!\n";
+    my @lines = <$fh>;
+    close($fh);
+    if ($ret != 0) {
+        die "Failed: $cmd\n" . join("", @lines);
+    }
+    foreach (@lines) {
+        $stats{$1} = $2 if (/^([a-z-]+) (\d+)$/);
+    }
+    return ($elapsed, \%stats);
+}
+
+sub median {
+    my @s = sort { $a <=> $b } @_;
+    my $n = scalar @s;
+    return ($n % 2) ? $s[($n - 1) / 2] : ($s[$n / 2 - 1] + $s[$n / 2]) / 2;
+}
+
+sub mean {
+    my $sum = 0;
+    $sum += $_ foreach (@_);
+    return $sum / scalar @_;
+}
+
+# sample variance
+sub variance {
+    my $n = scalar @_;
+    return 0 if ($n < 2);
+    my $m = mean(@_);
+    my $sum = 0;
+    $sum += ($_ - $m) ** 2 foreach (@_);
+    return $sum / ($n - 1);
+}
+
+my $base;
+if (defined $baseline) {
+    open(my $fh, "<", $baseline) or die "$baseline: $!\n";
+    local $/;
+    $base = decode_json(<$fh>)->{benchmarks};
+    close($fh);
+}
+
+my %results = ();
+printf("%-12s %6s %10s %10s %10s %10s %6s %10s\n",
+       "benchmark", "size", "median(s)", "stddev", "min", "max", "GCs", "RSS(KB)");
+
+foreach my $bench (@benches) {
+    my ($name, $size, $argsf) = @$bench;
+    next if (@only && !grep { $_ eq $name } @only);
+    $size = $sizes{$name} if (defined $sizes{$name});
+    my @args = $argsf->($size);
+
+    runOnce(@args) for (1..$warmup);
+
+    # peak RSS isn't available everywhere, so it stays undefined if cplof
+    # doesn't report it, rather than being shown as 0
+    my (@times, @gcs);
+    my $rss;
+    for (1..$reps) {
+        my ($elapsed, $stats) = runOnce(@args);
+        push @times, $elapsed;
+        push @gcs, $stats->{"gc-collections"} || 0;
+        my $r = $stats->{"peak-rss-kb"};
+        $rss = $r if (defined $r && (!defined $rss || $r > $rss));
+    }
+
+    my $r = {
+        size => $size + 0,
+        times => \@times,
+        median => median(@times),
+        mean => mean(@times),
+        variance => variance(@times),
+        stddev => sqrt(variance(@times)),
+        min => (sort { $a <=> $b } @times)[0],
+        max => (sort { $b <=> $a } @times)[0],
+        gc_collections => median(@gcs),
+        peak_rss_kb => $rss
+    };
+    $results{$name} = $r;
+
+    printf("%-12s %6d %10.4f %10.4f %10.4f %10.4f %6d %10s",
+           $name, $size, $r->{median}, $r->{stddev}, $r->{min}, $r->{max},
+           $r->{gc_collections}, defined $rss ? $rss : "n/a");
+    if ($base && $base->{$name}) {
+        my $old = $base->{$name};
+        if ($old->{size} != $size) {
+            print "  (baseline size differs)";
+        } elsif ($old->{median} > 0) {
+            printf("  %+.1f%% vs baseline", ($r->{median} - $old->{median}) * 100 / $old->{median});
+        }
+    }
+    print "\n";
+}
+
+if (defined $json) {
+    open(my $fh, ">", $json) or die "$json: $!\n";
+    print $fh JSON::PP->new->canonical->pretty->encode({
+        cplof => $cplof,
+        warmup => $warmup,
+        reps => $reps,
+        benchmarks => \%results
+    });
+    close($fh);
+}
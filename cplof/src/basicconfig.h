@@ -11,6 +11,12 @@
 /* We have unistd.h if we're on UNIX probably */
 #if defined(unix) || defined(__unix__) || defined(__unix)
 #define HAVE_UNISTD_H 1
+#define HAVE_SETITIMER 1
+#endif
+
+/* Linux has nanosecond file times */
+#if defined(__linux__)
+#define HAVE_STRUCT_STAT_ST_MTIM 1
 #endif
 
 /* Assume 32-bit */
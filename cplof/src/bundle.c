@@ -0,0 +1,186 @@
+/*
+ * Bundles of PSL appended to an executable
+ *
+ * Copyright (C) 2010 Gregor Richards
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <stdio.h>
+#include <string.h>
+
+#include "plof/bignum.h"
+#include "plof/bundle.h"
+#include "plof/memory.h"
+#include "plof/pslfile.h"
+
+/* A bundle is the magic, then a list of bignums:
+ *  the number of files
+ *  each file: whether to run it, name length, name, data length, data
+ * followed by the trailer: the bundle's length as eight big-endian bytes, then
+ * the magic again, so that it can be found from the end of the executable */
+#define PLOF_BUNDLE_TRAILER (8 + sizeof(PLOF_BUNDLE_MAGIC) - 1)
+
+struct PlofBundleFile *plofBundleFiles = NULL;
+size_t plofBundleFileCount = 0;
+
+/* the files sorted by name, for plofBundleFind */
+static struct PlofBundleFile **bundleIndex = NULL;
+
+static int bundleNameCmp(size_t alen, unsigned char *a, size_t blen, unsigned char *b)
+{
+    int c = memcmp(a, b, alen < blen ? alen : blen);
+    if (c) return c;
+    return (alen > blen) - (alen < blen);
+}
+
+/* read a bignum from the bundle, or return 0 if it runs off the end */
+static int bundleReadInt(unsigned char *buf, size_t sz, size_t *i, size_t *into)
+{
+    size_t j;
+    for (j = *i; j < sz && buf[j] >= 128; j++);
+    if (j >= sz) return 0;
+    *i += pslBignumToInt(buf + *i, into);
+    return 1;
+}
+
+/* load the bundle at the end of exe */
+size_t plofLoadBundle(const char *exe)
+{
+    FILE *fh;
+    unsigned char *buf, *magic;
+    size_t sz, blen, count, i, j, k;
+    struct PlofBundleFile *files, *f;
+
+    fh = fopen(exe, "rb");
+    if (fh == NULL) return 0;
+    buf = pslLoadFile(fh, &sz);
+    fclose(fh);
+
+    /* find it from the trailer */
+    if (sz < PLOF_BUNDLE_TRAILER) return 0;
+    magic = buf + sz - sizeof(PLOF_BUNDLE_MAGIC) + 1;
+    if (memcmp(magic, PLOF_BUNDLE_MAGIC, sizeof(PLOF_BUNDLE_MAGIC) - 1)) return 0;
+    for (blen = 0, i = sz - PLOF_BUNDLE_TRAILER; i < sz - PLOF_BUNDLE_TRAILER + 8; i++)
+        blen = (blen << 8) | buf[i];
+    if (blen > sz - PLOF_BUNDLE_TRAILER) goto bad;
+    sz -= PLOF_BUNDLE_TRAILER;
+    buf += sz - blen;
+    sz = blen;
+    if (sz < sizeof(PLOF_BUNDLE_MAGIC) - 1 ||
+        memcmp(buf, PLOF_BUNDLE_MAGIC, sizeof(PLOF_BUNDLE_MAGIC) - 1)) goto bad;
+
+    /* then read in the files */
+    i = sizeof(PLOF_BUNDLE_MAGIC) - 1;
+    if (!bundleReadInt(buf, sz, &i, &count) || count > sz) goto bad;
+    files = (struct PlofBundleFile *) GC_MALLOC(count * sizeof(struct PlofBundleFile));
+    for (j = 0; j < count; j++) {
+        size_t run;
+        f = &files[j];
+        if (!bundleReadInt(buf, sz, &i, &run)) goto bad;
+        f->run = (int) run;
+        if (!bundleReadInt(buf, sz, &i, &f->namelen) || f->namelen > sz - i) goto bad;
+        f->name = buf + i;
+        i += f->namelen;
+        if (!bundleReadInt(buf, sz, &i, &f->length) || f->length > sz - i) goto bad;
+        f->data = buf + i;
+        i += f->length;
+    }
+
+    /* index them by name (there are never many, so insertion sort is fine) */
+    bundleIndex = (struct PlofBundleFile **) GC_MALLOC(count * sizeof(struct PlofBundleFile *));
+    for (j = 0; j < count; j++) {
+        f = &files[j];
+        for (k = j; k > 0 &&
+             bundleNameCmp(bundleIndex[k-1]->namelen, bundleIndex[k-1]->name,
+                           f->namelen, f->name) > 0; k--)
+            bundleIndex[k] = bundleIndex[k-1];
+        bundleIndex[k] = f;
+    }
+
+    plofBundleFiles = files;
+    plofBundleFileCount = count;
+    return count;
+
+bad:
+    fprintf(stderr, "%s: Bad bundle!\n", exe);
+    return 0;
+}
+
+/* find a file in the bundle */
+unsigned char *plofBundleFind(size_t namelen, unsigned char *name, size_t *length)
+{
+    size_t lo = 0, hi = plofBundleFileCount, mid;
+    int c;
+
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        c = bundleNameCmp(bundleIndex[mid]->namelen, bundleIndex[mid]->name, namelen, name);
+        if (c == 0) {
+            *length = bundleIndex[mid]->length;
+            return bundleIndex[mid]->data;
+        } else if (c < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return NULL;
+}
+
+static void bundleWriteInt(struct Buffer_psl *out, size_t val)
+{
+    size_t len = pslBignumLength(val);
+    while (BUFFER_SPACE(*out) < len) EXPAND_BUFFER(*out);
+    pslIntToBignum(BUFFER_END(*out), val, len);
+    STEP_BUFFER(*out, len);
+}
+
+/* write out a bundle, returning 0 if the writes fail */
+int plofWriteBundle(FILE *to, size_t count, struct PlofBundleFile *files)
+{
+    struct Buffer_psl out;
+    unsigned char trailer[8];
+    size_t i, len;
+
+    INIT_ATOMIC_BUFFER(out);
+    WRITE_BUFFER(out, (unsigned char *) PLOF_BUNDLE_MAGIC, sizeof(PLOF_BUNDLE_MAGIC) - 1);
+    bundleWriteInt(&out, count);
+    for (i = 0; i < count; i++) {
+        bundleWriteInt(&out, files[i].run);
+        bundleWriteInt(&out, files[i].namelen);
+        WRITE_BUFFER(out, files[i].name, files[i].namelen);
+        bundleWriteInt(&out, files[i].length);
+        WRITE_BUFFER(out, files[i].data, files[i].length);
+    }
+    if (fwrite(out.buf, 1, out.bufused, to) != out.bufused) return 0;
+
+    /* and the trailer */
+    for (i = 8, len = out.bufused; i > 0; i--) {
+        trailer[i-1] = len & 0xFF;
+        len >>= 8;
+    }
+    if (fwrite(trailer, 1, 8, to) != 8) return 0;
+    if (fwrite(PLOF_BUNDLE_MAGIC, 1, sizeof(PLOF_BUNDLE_MAGIC) - 1, to) !=
+        sizeof(PLOF_BUNDLE_MAGIC) - 1) return 0;
+
+    return 1;
+}
@@ -0,0 +1,662 @@
+/*
+ * Heap images, snapshots of an initialized runtime
+ *
+ * Copyright (C) 2010 Gregor Richards
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "impl.h"
+#include "intrinsics.h"
+#include "plof/bignum.h"
+#include "plof/image.h"
+#include "plof/memory.h"
+#include "plof/psl.h"
+
+/* An image is the magic, then a list of bignums:
+ *  version, sizeof(void *), whether ints are free, the number of intrinsics,
+ *      helpers and intrinsic roots, then a native ptrdiff_t 1 (byte order)
+ *  a hash of the instruction table, and of the std.psl the image was made
+ *      with (0 if none)
+ *  the number of names, data and objects
+ *  each name: length, bytes
+ *  each data: type, then
+ *      raw: length, bytes, proc (0 for none, else an intrinsic or helper + 1)
+ *      array or locals: length, references
+ *      typed: kind, length, bytes (native order)
+ *      map: length, key and value references
+ *  each object: parent, data (index + 1, or 0), member count, then each
+ *      member's name index, hash and value
+ *  references to plofNull, plofGlobal, the context and the intrinsic roots
+ *  the extra data: length, bytes
+ * A reference is 0 for NULL, a free int itself (they're odd), or an object's
+ * index + 1 shifted left one */
+#define PLOF_IMAGE_VERSION 2
+
+#define BUFFER_GC
+#include "plof/buffer.h"
+BUFFER(ImageObject, struct PlofObject *);
+BUFFER(ImageData, struct PlofData *);
+BUFFER(ImageName, unsigned char *);
+BUFFER(ImageOffset, size_t);
+
+/* map from pointers to their index in the image. Everything in it is
+ * reachable from the roots anyway, so it's allocated atomic */
+struct ImageMap {
+    size_t capacity, length;
+    void **keys;
+    size_t *vals;
+};
+
+static void imageMapInit(struct ImageMap *map)
+{
+    map->capacity = 1024;
+    map->length = 0;
+    map->keys = (void **) GC_MALLOC_ATOMIC(map->capacity * sizeof(void *));
+    map->vals = (size_t *) GC_MALLOC_ATOMIC(map->capacity * sizeof(size_t));
+    memset(map->keys, 0, map->capacity * sizeof(void *));
+}
+
+static size_t imageMapSlot(struct ImageMap *map, void *key)
+{
+    size_t mask = map->capacity - 1;
+    size_t i = (((size_t) key >> 3) * 2654435761U) & mask;
+    while (map->keys[i] && map->keys[i] != key)
+        i = (i + 1) & mask;
+    return i;
+}
+
+/* get the index of key, or (size_t) -1 */
+static size_t imageMapGet(struct ImageMap *map, void *key)
+{
+    size_t i = imageMapSlot(map, key);
+    return map->keys[i] ? map->vals[i] : (size_t) -1;
+}
+
+static void imageMapPut(struct ImageMap *map, void *key, size_t val)
+{
+    size_t i;
+
+    /* keep it at most half full */
+    if ((map->length + 1) * 2 > map->capacity) {
+        struct ImageMap old = *map;
+        map->capacity *= 2;
+        map->keys = (void **) GC_MALLOC_ATOMIC(map->capacity * sizeof(void *));
+        map->vals = (size_t *) GC_MALLOC_ATOMIC(map->capacity * sizeof(size_t));
+        memset(map->keys, 0, map->capacity * sizeof(void *));
+        for (i = 0; i < old.capacity; i++) {
+            if (old.keys[i]) {
+                size_t ni = imageMapSlot(map, old.keys[i]);
+                map->keys[ni] = old.keys[i];
+                map->vals[ni] = old.vals[i];
+            }
+        }
+    }
+
+    i = imageMapSlot(map, key);
+    map->keys[i] = key;
+    map->vals[i] = val;
+    map->length++;
+}
+
+struct ImageWriter {
+    struct ImageMap objm, datam, namem;
+    struct Buffer_ImageObject objs;
+    struct Buffer_ImageData datas;
+    struct Buffer_ImageName names;
+    struct Buffer_psl out;
+};
+
+static void imageAddObject(struct ImageWriter *w, struct PlofObject *obj)
+{
+    if (obj == NULL || !ISOBJ(obj) || imageMapGet(&w->objm, obj) != (size_t) -1) return;
+    imageMapPut(&w->objm, obj, w->objs.bufused);
+    WRITE_BUFFER(w->objs, &obj, 1);
+}
+
+static void imageAddData(struct ImageWriter *w, struct PlofData *data)
+{
+    if (data == NULL || imageMapGet(&w->datam, data) != (size_t) -1) return;
+    imageMapPut(&w->datam, data, w->datas.bufused);
+    WRITE_BUFFER(w->datas, &data, 1);
+}
+
+static void imageAddName(struct ImageWriter *w, unsigned char *name)
+{
+    if (imageMapGet(&w->namem, name) != (size_t) -1) return;
+    imageMapPut(&w->namem, name, w->names.bufused);
+    WRITE_BUFFER(w->names, &name, 1);
+}
+
+/* write a bignum. Hashes and free ints use all of size_t, so this doesn't use
+ * pslBignumLength, which is limited by SIZEOF_VOID_P rather than size_t */
+static void imageWriteInt(struct ImageWriter *w, size_t val)
+{
+    size_t len, rest;
+    for (len = 1, rest = val >> 7; rest; rest >>= 7) len++;
+    while (BUFFER_SPACE(w->out) < len) EXPAND_BUFFER(w->out);
+    pslIntToBignum(BUFFER_END(w->out), val, len);
+    STEP_BUFFER(w->out, len);
+}
+
+static void imageWriteRef(struct ImageWriter *w, struct PlofObject *obj)
+{
+    if (obj == NULL) {
+        imageWriteInt(w, 0);
+    } else if (!ISOBJ(obj)) {
+        imageWriteInt(w, (size_t) obj);
+    } else {
+        imageWriteInt(w, (imageMapGet(&w->objm, obj) + 1) << 1);
+    }
+}
+
+/* the number a proc is saved as, or (size_t) -1 if it isn't one we know */
+static size_t imageProcNumber(PlofFunction proc)
+{
+    size_t i;
+    if (proc == NULL) return 0;
+    for (i = 0; i < plofIntrinsicCount; i++)
+        if (plofIntrinsics[i] == proc) return i + 1;
+    for (i = 0; i < plofIntrinsicHelperCount; i++)
+        if (plofIntrinsicHelpers[i] == proc) return plofIntrinsicCount + i + 1;
+    return (size_t) -1;
+}
+
+static int imageMemberCount(struct PlofObject *obj)
+{
+    struct PlofOHashTable *cur;
+    int i, count = 0;
+    if (obj->hashTable) {
+        for (i = 0; i < PLOF_HASHTABLE_SIZE; i++)
+            for (cur = &obj->hashTable->elems[i]; cur && cur->name; cur = cur->next)
+                count++;
+    }
+    return count;
+}
+
+/* return true if this buffer points to a heap image */
+int isPlofImage(size_t sz, unsigned char *buf)
+{
+    return (sz >= sizeof(PLOF_IMAGE_MAGIC) - 1 &&
+            !memcmp(PLOF_IMAGE_MAGIC, (char *) buf, sizeof(PLOF_IMAGE_MAGIC) - 1));
+}
+
+/* hash the instruction names and numbers, so an image from a build with a
+ * different instruction set is refused rather than misinterpreted */
+static size_t imageBuildHash()
+{
+    static const char *names[] = {
+#define FOREACH(inst) #inst,
+#include "psl_inst.h"
+#undef FOREACH
+        NULL
+    };
+    static const unsigned char ops[] = {
+#define FOREACH(inst) psl_ ## inst,
+#include "psl_inst.h"
+#undef FOREACH
+        0
+    };
+    size_t hash = plofHash(sizeof(ops), (unsigned char *) ops);
+    int i;
+
+    for (i = 0; names[i]; i++)
+        hash = hash * 31 + plofHash(strlen(names[i]), (unsigned char *) names[i]);
+    return hash;
+}
+
+/* write out an image of the heap */
+int plofWriteImage(FILE *to, struct PlofObject *context, size_t stdhash, size_t extralen, unsigned char *extra)
+{
+    struct ImageWriter w;
+    struct PlofOHashTable *cur;
+    size_t oi, di, i, j;
+    ptrdiff_t one = 1;
+
+    imageMapInit(&w.objm);
+    imageMapInit(&w.datam);
+    imageMapInit(&w.namem);
+    INIT_BUFFER(w.objs);
+    INIT_BUFFER(w.datas);
+    INIT_BUFFER(w.names);
+    INIT_ATOMIC_BUFFER(w.out);
+
+    /* find everything reachable from the roots. The heap can be very deep
+     * (lists, ropes), so this is a worklist rather than a recursion */
+    imageAddObject(&w, plofNull);
+    imageAddObject(&w, plofGlobal);
+    imageAddObject(&w, context);
+    for (i = 0; i < plofIntrinsicRootCount; i++)
+        imageAddObject(&w, *plofIntrinsicRoots[i]);
+
+    for (oi = di = 0; oi < w.objs.bufused || di < w.datas.bufused;) {
+        for (; oi < w.objs.bufused; oi++) {
+            struct PlofObject *obj = w.objs.buf[oi];
+            imageAddObject(&w, obj->parent);
+            imageAddData(&w, obj->data);
+            if (obj->hashTable) {
+                for (i = 0; i < PLOF_HASHTABLE_SIZE; i++) {
+                    for (cur = &obj->hashTable->elems[i]; cur && cur->name; cur = cur->next) {
+                        imageAddName(&w, cur->name);
+                        imageAddObject(&w, cur->value);
+                    }
+                }
+            }
+        }
+
+        for (; di < w.datas.bufused; di++) {
+            struct PlofData *data = w.datas.buf[di];
+            switch (data->type) {
+                case PLOF_DATA_RAW:
+                {
+                    struct PlofRawData *rd = (struct PlofRawData *) data;
+                    if (!rd->data) plofRawFlatten(rd);
+                    if (imageProcNumber(rd->proc) == (size_t) -1) {
+                        fprintf(stderr, "Cannot image a procedure with an unknown native implementation!\n");
+                        return 0;
+                    }
+                    break;
+                }
+
+                case PLOF_DATA_ARRAY:
+                case PLOF_DATA_LOCALS:
+                {
+                    struct PlofArrayData *ad = (struct PlofArrayData *) data;
+                    for (i = 0; i < ad->length; i++)
+                        imageAddObject(&w, ad->data[i]);
+                    break;
+                }
+
+                case PLOF_DATA_TYPED:
+                    break;
+
+                case PLOF_DATA_MAP:
+                {
+                    struct PlofMapData *md = (struct PlofMapData *) data;
+                    for (i = 0; i < md->capacity; i++) {
+                        if (md->slots[i].key) {
+                            imageAddObject(&w, md->slots[i].key);
+                            imageAddObject(&w, md->slots[i].value);
+                        }
+                    }
+                    break;
+                }
+
+                default:
+                    fprintf(stderr, "Cannot image data of type %d!\n", data->type);
+                    return 0;
+            }
+        }
+    }
+
+    /* header */
+    WRITE_BUFFER(w.out, PLOF_IMAGE_MAGIC, sizeof(PLOF_IMAGE_MAGIC) - 1);
+    imageWriteInt(&w, PLOF_IMAGE_VERSION);
+    imageWriteInt(&w, sizeof(void *));
+    imageWriteInt(&w, !ISOBJ((struct PlofObject *) 1));
+    imageWriteInt(&w, plofIntrinsicCount);
+    imageWriteInt(&w, plofIntrinsicHelperCount);
+    imageWriteInt(&w, plofIntrinsicRootCount);
+    WRITE_BUFFER(w.out, (unsigned char *) &one, sizeof(ptrdiff_t));
+    imageWriteInt(&w, imageBuildHash());
+    imageWriteInt(&w, stdhash);
+
+    imageWriteInt(&w, w.names.bufused);
+    imageWriteInt(&w, w.datas.bufused);
+    imageWriteInt(&w, w.objs.bufused);
+
+    /* names */
+    for (i = 0; i < w.names.bufused; i++) {
+        size_t len = strlen((char *) w.names.buf[i]);
+        imageWriteInt(&w, len);
+        WRITE_BUFFER(w.out, w.names.buf[i], len);
+    }
+
+    /* data */
+    for (i = 0; i < w.datas.bufused; i++) {
+        struct PlofData *data = w.datas.buf[i];
+        imageWriteInt(&w, data->type);
+        switch (data->type) {
+            case PLOF_DATA_RAW:
+            {
+                struct PlofRawData *rd = (struct PlofRawData *) data;
+                imageWriteInt(&w, rd->length);
+                WRITE_BUFFER(w.out, rd->data, rd->length);
+                imageWriteInt(&w, imageProcNumber(rd->proc));
+                break;
+            }
+
+            case PLOF_DATA_ARRAY:
+            case PLOF_DATA_LOCALS:
+            {
+                struct PlofArrayData *ad = (struct PlofArrayData *) data;
+                imageWriteInt(&w, ad->length);
+                for (j = 0; j < ad->length; j++)
+                    imageWriteRef(&w, ad->data[j]);
+                break;
+            }
+
+            case PLOF_DATA_TYPED:
+            {
+                struct PlofTypedData *td = (struct PlofTypedData *) data;
+                imageWriteInt(&w, td->kind);
+                imageWriteInt(&w, td->length);
+                WRITE_BUFFER(w.out, td->data, td->length * td->width);
+                break;
+            }
+
+            case PLOF_DATA_MAP:
+            {
+                struct PlofMapData *md = (struct PlofMapData *) data;
+                imageWriteInt(&w, md->length);
+                for (j = 0; j < md->capacity; j++) {
+                    if (md->slots[j].key) {
+                        imageWriteRef(&w, md->slots[j].key);
+                        imageWriteRef(&w, md->slots[j].value);
+                    }
+                }
+                break;
+            }
+        }
+    }
+
+    /* objects */
+    for (i = 0; i < w.objs.bufused; i++) {
+        struct PlofObject *obj = w.objs.buf[i];
+        imageWriteRef(&w, obj->parent);
+        imageWriteInt(&w, obj->data ? imageMapGet(&w.datam, obj->data) + 1 : 0);
+        imageWriteInt(&w, imageMemberCount(obj));
+        if (obj->hashTable) {
+            for (j = 0; j < PLOF_HASHTABLE_SIZE; j++) {
+                for (cur = &obj->hashTable->elems[j]; cur && cur->name; cur = cur->next) {
+                    imageWriteInt(&w, imageMapGet(&w.namem, cur->name));
+                    imageWriteInt(&w, cur->hashedName);
+                    imageWriteRef(&w, cur->value);
+                }
+            }
+        }
+    }
+
+    /* roots */
+    imageWriteRef(&w, plofNull);
+    imageWriteRef(&w, plofGlobal);
+    imageWriteRef(&w, context);
+    for (i = 0; i < plofIntrinsicRootCount; i++)
+        imageWriteRef(&w, *plofIntrinsicRoots[i]);
+
+    /* and the extra data */
+    imageWriteInt(&w, extralen);
+    WRITE_BUFFER(w.out, extra, extralen);
+
+    if (fwrite(w.out.buf, 1, w.out.bufused, to) != w.out.bufused) {
+        perror("Writing image");
+        return 0;
+    }
+    return 1;
+}
+
+struct ImageReader {
+    unsigned char *buf;
+    size_t sz, i;
+    int bad;
+    struct PlofObject **objs;
+    size_t objCount;
+};
+
+static size_t imageReadInt(struct ImageReader *r)
+{
+    size_t ret = 0;
+    for (;; r->i++) {
+        if (r->i >= r->sz) {
+            r->bad = 1;
+            return 0;
+        }
+        ret = (ret << 7) | (r->buf[r->i] & 0x7F);
+        if (r->buf[r->i] < 128) break;
+    }
+    r->i++;
+    return ret;
+}
+
+static unsigned char *imageReadBytes(struct ImageReader *r, size_t len)
+{
+    unsigned char *ret = r->buf + r->i;
+    if (len > r->sz - r->i) {
+        r->bad = 1;
+        return NULL;
+    }
+    r->i += len;
+    return ret;
+}
+
+static struct PlofObject *imageReadRef(struct ImageReader *r)
+{
+    size_t ref = imageReadInt(r);
+    if (ref == 0) {
+        return NULL;
+    } else if (ref & 1) {
+        if (ISOBJ((struct PlofObject *) ref)) r->bad = 1;
+        return (struct PlofObject *) ref;
+    }
+    ref = (ref >> 1) - 1;
+    if (ref >= r->objCount) {
+        r->bad = 1;
+        return NULL;
+    }
+    return r->objs[ref];
+}
+
+/* read in an image of the heap */
+struct PlofObject *plofReadImage(size_t sz, unsigned char *buf, size_t stdhash, struct Buffer_psl *extra)
+{
+    struct ImageReader r;
+    struct PlofData **datas;
+    unsigned char **names;
+    unsigned char *bytes;
+    struct Buffer_ImageOffset maps;
+    struct PlofObject *context, **roots;
+    size_t nameCount, dataCount, i, j, len;
+    ptrdiff_t one = 1;
+
+    if (!isPlofImage(sz, buf)) {
+        fprintf(stderr, "Not a heap image!\n");
+        return NULL;
+    }
+    r.buf = buf;
+    r.sz = sz;
+    r.i = sizeof(PLOF_IMAGE_MAGIC) - 1;
+    r.bad = 0;
+
+    /* make sure it's from a compatible build */
+    if (imageReadInt(&r) != PLOF_IMAGE_VERSION ||
+        imageReadInt(&r) != sizeof(void *) ||
+        imageReadInt(&r) != !ISOBJ((struct PlofObject *) 1) ||
+        imageReadInt(&r) != plofIntrinsicCount ||
+        imageReadInt(&r) != plofIntrinsicHelperCount ||
+        imageReadInt(&r) != plofIntrinsicRootCount ||
+        (bytes = imageReadBytes(&r, sizeof(ptrdiff_t))) == NULL ||
+        memcmp(bytes, &one, sizeof(ptrdiff_t)) ||
+        imageReadInt(&r) != imageBuildHash()) {
+        fprintf(stderr, "Heap image is from an incompatible build of Plof!\n");
+        return NULL;
+    }
+    i = imageReadInt(&r);
+    if (i && stdhash && i != stdhash) {
+        fprintf(stderr, "Heap image was made with a different std.psl!\n");
+        return NULL;
+    }
+
+    nameCount = imageReadInt(&r);
+    dataCount = imageReadInt(&r);
+    r.objCount = imageReadInt(&r);
+    if (r.bad || nameCount > sz || dataCount > sz || r.objCount > sz) goto bad;
+
+    /* make all the objects first, so that references can be resolved */
+    r.objs = (struct PlofObject **) GC_MALLOC(r.objCount * sizeof(struct PlofObject *));
+    for (i = 0; i < r.objCount; i++)
+        r.objs[i] = newPlofObject();
+
+    /* names */
+    names = (unsigned char **) GC_MALLOC(nameCount * sizeof(unsigned char *));
+    for (i = 0; i < nameCount && !r.bad; i++) {
+        len = imageReadInt(&r);
+        bytes = imageReadBytes(&r, len);
+        if (r.bad) break;
+        names[i] = (unsigned char *) GC_MALLOC_ATOMIC(len + 1);
+        memcpy(names[i], bytes, len);
+        names[i][len] = '\0';
+    }
+
+    /* data */
+    datas = (struct PlofData **) GC_MALLOC(dataCount * sizeof(struct PlofData *));
+    INIT_BUFFER(maps);
+    for (i = 0; i < dataCount && !r.bad; i++) {
+        size_t type = imageReadInt(&r);
+        switch (type) {
+            case PLOF_DATA_RAW:
+            {
+                struct PlofRawData *rd;
+                size_t proc;
+                len = imageReadInt(&r);
+                bytes = imageReadBytes(&r, len);
+                proc = imageReadInt(&r);
+                if (r.bad || proc > plofIntrinsicCount + plofIntrinsicHelperCount) goto bad;
+
+                rd = newPlofRawData(len);
+                memcpy(rd->data, bytes, len);
+                if (proc > plofIntrinsicCount) {
+                    rd->proc = plofIntrinsicHelpers[proc - plofIntrinsicCount - 1];
+                } else if (proc > 0 && plofLoadIntrinsics) {
+                    rd->proc = plofIntrinsics[proc - 1];
+                }
+                datas[i] = (struct PlofData *) rd;
+                break;
+            }
+
+            case PLOF_DATA_ARRAY:
+            case PLOF_DATA_LOCALS:
+            {
+                struct PlofArrayData *ad;
+                len = imageReadInt(&r);
+                if (r.bad || len > sz) goto bad;
+
+                ad = newPlofArrayData(len);
+                ad->type = type;
+                for (j = 0; j < len; j++)
+                    ad->data[j] = imageReadRef(&r);
+                datas[i] = (struct PlofData *) ad;
+                break;
+            }
+
+            case PLOF_DATA_TYPED:
+            {
+                struct PlofTypedData *td;
+                int kind = imageReadInt(&r);
+                len = imageReadInt(&r);
+                if (r.bad || len > sz) goto bad;
+
+                td = newPlofTypedData(kind, len);
+                if (td == NULL) goto bad;
+                bytes = imageReadBytes(&r, len * td->width);
+                if (r.bad) goto bad;
+                memcpy(td->data, bytes, len * td->width);
+                datas[i] = (struct PlofData *) td;
+                break;
+            }
+
+            case PLOF_DATA_MAP:
+            {
+                /* maps are filled in once the objects are, as keys are hashed
+                 * by their content */
+                WRITE_BUFFER(maps, &i, 1);
+                WRITE_BUFFER(maps, &r.i, 1);
+                len = imageReadInt(&r);
+                for (j = 0; j < len * 2 && !r.bad; j++)
+                    imageReadRef(&r);
+                datas[i] = (struct PlofData *) newPlofMapData();
+                break;
+            }
+
+            default:
+                goto bad;
+        }
+    }
+    if (r.bad) goto bad;
+
+    /* objects */
+    for (i = 0; i < r.objCount && !r.bad; i++) {
+        struct PlofObject *obj = r.objs[i];
+        size_t members;
+
+        obj->parent = imageReadRef(&r);
+        j = imageReadInt(&r);
+        if (j > dataCount) goto bad;
+        obj->data = j ? datas[j - 1] : NULL;
+
+        members = imageReadInt(&r);
+        for (j = 0; j < members && !r.bad; j++) {
+            size_t name = imageReadInt(&r);
+            size_t hash = imageReadInt(&r);
+            struct PlofObject *value = imageReadRef(&r);
+            if (name >= nameCount) goto bad;
+            plofWrite(obj, names[name], hash, value);
+        }
+    }
+
+    /* roots */
+    roots = (struct PlofObject **) GC_MALLOC((plofIntrinsicRootCount + 3) * sizeof(struct PlofObject *));
+    for (i = 0; i < plofIntrinsicRootCount + 3; i++)
+        roots[i] = imageReadRef(&r);
+
+    /* extra */
+    len = imageReadInt(&r);
+    bytes = imageReadBytes(&r, len);
+    if (r.bad || !roots[0] || !roots[1] || !roots[2]) goto bad;
+
+    /* now the maps */
+    for (i = 0; i < maps.bufused; i += 2) {
+        struct PlofMapData *md = (struct PlofMapData *) datas[maps.buf[i]];
+        r.i = maps.buf[i + 1];
+        len = imageReadInt(&r);
+        for (j = 0; j < len; j++) {
+            struct PlofObject *key = imageReadRef(&r);
+            struct PlofObject *value = imageReadRef(&r);
+            if (!ISRAW(key) && !ISINT(key)) goto bad;
+            plofMapPut(md, key, value);
+        }
+    }
+
+    INIT_ATOMIC_BUFFER(*extra);
+    WRITE_BUFFER(*extra, bytes, len);
+
+    plofNull = roots[0];
+    plofGlobal = roots[1];
+    context = roots[2];
+    for (i = 0; i < plofIntrinsicRootCount; i++)
+        *plofIntrinsicRoots[i] = roots[i + 3];
+
+    return context;
+
+bad:
+    fprintf(stderr, "Heap image is corrupt!\n");
+    return NULL;
+}
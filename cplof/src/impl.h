@@ -53,11 +53,9 @@
 /* Basic type-checks */
 #define BADTYPE(cmd) \
 { \
-    rd = newPlofRawData(sizeof(cmd)-1 + 15); \
-    sprintf((char *) rd->data, "Type error in %s", cmd); \
-    a = newPlofObject(); \
+    a = newPlofObjectWithRaw(sizeof(cmd)-1 + 15); \
     a->parent = plofNull; \
-    a->data = (struct PlofData *) rd; \
+    sprintf((char *) RAW(a)->data, "Type error in %s", cmd); \
     \
     ret.ret = newPlofObject(); \
     ret.ret->parent = plofNull; \
@@ -86,9 +84,21 @@
 #define ISLOCALS(obj) (ISOBJ(obj) && \
                   (obj)->data && \
                   (obj)->data->type == PLOF_DATA_LOCALS)
-#define RAW(obj) ((struct PlofRawData *) (obj)->data)
+#define ISTYPED(obj) (ISOBJ(obj) && \
+                  (obj)->data && \
+                  (obj)->data->type == PLOF_DATA_TYPED)
+#define ISMAP(obj) (ISOBJ(obj) && \
+                  (obj)->data && \
+                  (obj)->data->type == PLOF_DATA_MAP)
+/* RAW flattens ropes, RAWROPE is for operations that can work with them */
+#define RAWROPE(obj) ((struct PlofRawData *) (obj)->data)
+#define RAW(obj) (RAWROPE(obj)->data ? RAWROPE(obj) : plofRawFlatten(RAWROPE(obj)))
+/* RAWSTR is RAW with data usable as a C string (views are unshared) */
+#define RAWSTR(obj) plofRawUnshare(RAW(obj))
 #define ARRAY(obj) ((struct PlofArrayData *) (obj)->data)
 #define LOCALS(obj) ((struct PlofArrayData *) (obj)->data)
+#define TYPED(obj) ((struct PlofTypedData *) (obj)->data)
+#define MAP(obj) ((struct PlofMapData *) (obj)->data)
 #define RAWSTRDUP(type, into, _rd) \
 { \
     unsigned char *_into = (unsigned char *) GC_MALLOC_ATOMIC((_rd)->length + 1); \
@@ -112,10 +122,12 @@ if ((rd)->hash) { \
 #define ISINT(obj) (ISRAW(obj) && RAW(obj)->length == sizeof(ptrdiff_t))
 #define ASINT(obj) (*((ptrdiff_t *) RAW(obj)->data))
 #define SETINT(obj, val) ASINT(obj) = (val)
+#define PLOF_INT_MAX ((ptrdiff_t) ((size_t) -1 >> 1))
 #elif defined(PLOF_FREE_INTS)
 #define ISINT(obj) ((size_t)(obj)&1)
 #define ASINT(obj) ((ptrdiff_t)(obj)>>1)
 #define SETINT(obj, val) (obj) = (void *) (((ptrdiff_t)(val)<<1) | 1)
+#define PLOF_INT_MAX ((ptrdiff_t) ((size_t) -1 >> 2))
 #endif
 
 /* Type coercions */
@@ -246,7 +258,7 @@ if (cpsli >= 4 && cpsl[cpsli-4] == pslCompileLabels[label_psl_code] && cpsl[cpsl
     cpslibase = cpsli; \
  \
     /* compile the first one */ \
-    ret = compilePSL(rda->length, rda->data, 0, &cpslalen, &cpslai, cpslargs, &cpsllena, &cpslargs); \
+    ret = compilePSL(rda->length, rda->data, rda, 0, &cpslalen, &cpslai, cpslargs, &cpsllena, &cpslargs); \
     cpsla = ((struct CPSLArgsHeader *) cpslargs)->cpsl; \
     if (stacksize + ((struct CPSLArgsHeader *) cpslargs)->maxstacksize > maxstacksize) \
         maxstacksize = stacksize + ((struct CPSLArgsHeader *) cpslargs)->maxstacksize; \
@@ -254,7 +266,7 @@ if (cpsli >= 4 && cpsl[cpsli-4] == pslCompileLabels[label_psl_code] && cpsl[cpsl
     if (ret.isThrown) return ret; \
  \
     /* compile the second one */ \
-    ret = compilePSL(rdb->length, rdb->data, 0, &cpslalen, &cpslai, cpslargs, &cpsllenb, &cpslargs); \
+    ret = compilePSL(rdb->length, rdb->data, rdb, 0, &cpslalen, &cpslai, cpslargs, &cpsllenb, &cpslargs); \
     cpslb = ((struct CPSLArgsHeader *) cpslargs)->cpsl; \
     if (stacksize + ((struct CPSLArgsHeader *) cpslargs)->maxstacksize > maxstacksize) \
         maxstacksize = stacksize + ((struct CPSLArgsHeader *) cpslargs)->maxstacksize; \
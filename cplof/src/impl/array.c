@@ -4,7 +4,8 @@ label(interp_psl_array);
         size_t length = 0;
         ptrdiff_t arri;
         struct PlofObject **stacki, *otmp;
-        length = arri = 0;
+        length = 0;
+        arri = -1;
 
         if (pc[1]) {
             /* compiled in */
@@ -6,13 +6,11 @@ label(interp_psl_byte);
         struct PlofObject *otmp;
 
         /* prepare the new value */
-        rd = newPlofRawData(1);
-        rd->data[0] = (unsigned char) (val & 0xFF);
+        otmp = newPlofObjectWithRaw(1);
+        otmp->parent = context;
+        RAW(otmp)->data[0] = (unsigned char) (val & 0xFF);
 
         /* and push it */
-        otmp = (struct PlofObject *) newPlofObject();
-        otmp->parent = context;
-        otmp->data = (struct PlofData *) rd;
         STACK_PUSH(otmp);
     } else {
         BADTYPE("byte");
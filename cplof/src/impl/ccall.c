@@ -87,11 +87,10 @@ label(interp_psl_ccall);
         ffi_call(&cif->cif, func, cret, args);
 
         /* and put the return together */
-        rd = newPlofRawData(cif->rtype->size);
-        memcpy(rd->data, cret, rd->length);
-        otmp = newPlofObject();
+        otmp = newPlofObjectWithRaw(cif->rtype->size);
         otmp->parent = context;
-        otmp->data = (struct PlofData *) rd;
+        rd = RAW(otmp);
+        memcpy(rd->data, cret, rd->length);
 
         STACK_PUSH(otmp);
 
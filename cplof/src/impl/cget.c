@@ -10,12 +10,10 @@ label(interp_psl_cget);
         struct PlofObject *otmp;
 
         /* construct a raw data object */
-        rd = newPlofRawData(ASINT(b));
-        memcpy(rd->data, ASPTR(a), rd->length);
-
-        otmp = newPlofObject();
+        otmp = newPlofObjectWithRaw(ASINT(b));
         otmp->parent = context;
-        otmp->data = (struct PlofData *) rd;
+        rd = RAW(otmp);
+        memcpy(rd->data, ASPTR(a), rd->length);
 
         STACK_PUSH(otmp);
 
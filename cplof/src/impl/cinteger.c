@@ -7,7 +7,7 @@ label(interp_psl_cinteger);
 
         /* get the value */
         if (ISRAW(a)) {
-            rd = (struct PlofRawData *) a->data;
+            rd = RAW(a);
             val = parseRawCInt(rd);
         }
 
@@ -5,12 +5,10 @@ label(interp_psl_concat);
         struct PlofRawData *ra, *rb;
         struct PlofObject *otmp;
 
-        ra = RAW(a);
-        rb = RAW(b);
+        ra = RAWROPE(a);
+        rb = RAWROPE(b);
 
-        rd = newPlofRawData(ra->length + rb->length);
-        memcpy(rd->data, ra->data, ra->length);
-        memcpy(rd->data + ra->length, rb->data, rb->length);
+        rd = plofRawConcat(ra, rb);
 
         otmp = newPlofObject();
         otmp->parent = context;
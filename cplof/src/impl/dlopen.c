@@ -12,7 +12,7 @@ label(interp_psl_dlopen);
         unsigned char *fname = NULL;
         if (a != plofNull) {
             if (ISRAW(a)) {
-                fname = RAW(a)->data;
+                fname = RAWSTR(a)->data;
             } else {
                 BADTYPE("dlopen");
             }
@@ -24,7 +24,7 @@ label(interp_psl_dlsym);
 
         /* the function name can't */
         if (ISRAW(b)) {
-            fname = RAW(b)->data;
+            fname = RAWSTR(b)->data;
 
             fun = dlsym(hnd, (char *) fname);
 
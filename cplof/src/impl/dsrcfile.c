@@ -3,7 +3,7 @@ label(interp_psl_dsrcfile);
     UNARY;
     if (ISRAW(a)) {
         if (dfile == NULL) {
-            dfile = RAW(a)->data;
+            dfile = RAWSTR(a)->data;
         }
     } else {
         BADTYPE("dsrcfile");
@@ -1,5 +1,5 @@
 #ifdef PLOF_NO_PARSER
-label(interp_psl_gadd); DEBUG_CMD("gadd"); STEP;
+label(interp_psl_gadd); DEBUG_CMD("gadd"); QUATERNARY; STEP;
 #else
 
 label(interp_psl_gadd);
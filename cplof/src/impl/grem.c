@@ -1,5 +1,5 @@
 #ifdef PLOF_NO_PARSER
-label(interp_psl_grem); DEBUG_CMD("grem"); STEP;
+label(interp_psl_grem); DEBUG_CMD("grem"); UNARY; STEP;
 #else
 
 label(interp_psl_grem);
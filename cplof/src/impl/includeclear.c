@@ -0,0 +1,4 @@
+label(interp_psl_includeclear);
+    DEBUG_CMD("includeclear");
+    plofIncludeCacheClear();
+    STEP;
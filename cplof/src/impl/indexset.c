@@ -6,13 +6,8 @@ label(interp_psl_indexset);
         ad = ARRAY(a);
 
         /* make sure it's long enough */
-        if (index >= ad->length) {
-            size_t i = ad->length;
-            ad->length = index + 1;
-            ad->data = GC_REALLOC(ad->data, ad->length * sizeof(struct PlofObject *));
-            for (; i < ad->length; i++) {
-                ad->data[i] = plofNull;
-            }
+        if (index >= (ptrdiff_t) ad->length) {
+            plofArrayResize(ad, index + 1);
         }
 
         /* then set it */
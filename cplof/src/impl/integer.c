@@ -20,7 +20,7 @@ label(interp_psl_integer);
 
             /* get the value */
             if (ISRAW(a)) {
-                rd = (struct PlofRawData *) a->data;
+                rd = RAW(a);
                 val = parseRawInt(rd);
             }
     
@@ -2,9 +2,9 @@ label(interp_psl_intrinsic);
     DEBUG_CMD("intrinsic");
     BINARY;
     if (ISRAW(a) && ISINT(b)) {
-        if (plofLoadIntrinsics) {
+        ptrdiff_t intr = ASINT(b);
+        if (plofLoadIntrinsics && intr >= 0 && intr < (ptrdiff_t) plofIntrinsicCount) {
             /* save the intrinsic function represented by b into a, push a */
-            ptrdiff_t intr = ASINT(b);
             rd = RAW(a);
             rd->proc = plofIntrinsics[intr];
         }
@@ -3,6 +3,10 @@ label(interp_psl_length);
     UNARY;
     if (ISARRAY(a)) {
         PUSHINT(ARRAY(a)->length);
+    } else if (ISTYPED(a)) {
+        PUSHINT(TYPED(a)->length);
+    } else if (ISMAP(a)) {
+        PUSHINT(MAP(a)->length);
     } else {
         BADTYPE("length");
         PUSHINT(0);
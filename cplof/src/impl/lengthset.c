@@ -1,19 +1,9 @@
 label(interp_psl_lengthset);
     DEBUG_CMD("lengthset");
     BINARY;
-    if (ISARRAY(a) && ISINT(b)) {
-        size_t oldlen, newlen, i;
-        ad = ARRAY(a);
-        oldlen = ad->length;
-        newlen = ASINT(b);
-
-        /* reallocate */
-        ad->data = (struct PlofObject **) GC_REALLOC(ad->data, newlen * sizeof(struct PlofObject *));
-
-        /* and assign nulls */
-        for (i = oldlen; i < newlen; i++) {
-            ad->data[i] = plofNull;
-        }
+    if (ISARRAY(a) && ISINT(b) && ASINT(b) >= 0) {
+        /* resize, assigning nulls */
+        plofArrayResize(ARRAY(a), ASINT(b));
     } else {
         BADTYPE("lengthset");
     }
@@ -0,0 +1,9 @@
+label(interp_psl_map);
+    DEBUG_CMD("map");
+    {
+        struct PlofObject *otmp = newPlofObject();
+        otmp->parent = context;
+        otmp->data = (struct PlofData *) newPlofMapData();
+        STACK_PUSH(otmp);
+    }
+    STEP;
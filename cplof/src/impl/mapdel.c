@@ -0,0 +1,9 @@
+label(interp_psl_mapdel);
+    DEBUG_CMD("mapdel");
+    BINARY;
+    if (ISMAP(a) && (ISINT(b) || ISRAW(b))) {
+        plofMapRemove(MAP(a), b);
+    } else {
+        BADTYPE("mapdel");
+    }
+    STEP;
@@ -0,0 +1,11 @@
+label(interp_psl_mapget);
+    DEBUG_CMD("mapget");
+    BINARY;
+    if (ISMAP(a) && (ISINT(b) || ISRAW(b))) {
+        struct PlofObject *otmp = plofMapGet(MAP(a), b);
+        STACK_PUSH(otmp ? otmp : plofNull);
+    } else {
+        BADTYPE("mapget");
+        STACK_PUSH(plofNull);
+    }
+    STEP;
@@ -0,0 +1,15 @@
+label(interp_psl_mapkeys);
+    DEBUG_CMD("mapkeys");
+    UNARY;
+    if (ISMAP(a)) {
+        struct PlofObject *otmp;
+        ad = plofMapKeys(MAP(a));
+        otmp = newPlofObject();
+        otmp->parent = context;
+        otmp->data = (struct PlofData *) ad;
+        STACK_PUSH(otmp);
+    } else {
+        BADTYPE("mapkeys");
+        STACK_PUSH(plofNull);
+    }
+    STEP;
@@ -0,0 +1,9 @@
+label(interp_psl_mapset);
+    DEBUG_CMD("mapset");
+    TRINARY;
+    if (ISMAP(a) && (ISINT(b) || ISRAW(b))) {
+        plofMapPut(MAP(a), b, c);
+    } else {
+        BADTYPE("mapset");
+    }
+    STEP;
@@ -4,7 +4,7 @@ label(interp_psl_memberset);
     if (ISOBJ(a) && ISRAW(b)) {
         unsigned char *name;
         size_t namehash;
-        rd = RAW(b);
+        rd = RAWSTR(b);
         name = rd->data;
         HASHOF(namehash, rd);
 
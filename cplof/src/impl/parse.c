@@ -3,41 +3,60 @@ label(interp_psl_parse);
     TRINARY;
 
     if (ISRAW(a) && ISRAW(b) && ISRAW(c)) {
-        struct PlofRawData *retrd, *brd, *crd;
+        struct PlofRawData *prd;
         struct PlofObject *otmp;
+        struct Buffer_psl psl;
+#ifndef PLOF_NO_PARSER
+        struct PlofRawData *brd, *crd;
+        int parsed = 0;
+#endif
 
         rd = RAW(a);
-        brd = RAW(b);
-        crd = RAW(c);
+#ifndef PLOF_NO_PARSER
+        brd = RAWSTR(b);
+        crd = RAWSTR(c);
+#endif
+        memset(&psl, 0, sizeof(struct Buffer_psl));
+        prd = NULL;
 
         /* check if it's a PSL file */
         if (isPSLFile(rd->length, rd->data)) {
-            struct Buffer_psl psl = readPSLFile(rd->length, rd->data);
+            psl = readPSLFile(rd->length, rd->data);
 
             /* if we didn't find one, this is bad */
             if (psl.buf == NULL) {
                 BADTYPE("parse psl");
-                retrd = newPlofRawData(0);
-            } else {
-                retrd = newPlofRawData(psl.bufused);
-                memcpy(retrd->data, psl.buf, psl.bufused);
             }
 
         } else {
 #ifdef PLOF_NO_PARSER
             BADTYPE("parse not psl");
 #else
-            struct Buffer_psl psl = parseAll(rd->data, brd->data, crd->data);
-            retrd = newPlofRawData(psl.bufused);
-            memcpy(retrd->data, psl.buf, psl.bufused);
+            /* an included file may have been parsed already */
+            rd = RAWSTR(a);
+            prd = plofIncludeParsedGet(rd, brd, crd);
+            if (prd == NULL) {
+                psl = parseAll(rd->data, brd->data, crd->data);
+                parsed = (psl.buf != NULL);
+            }
 #endif
 
         }
 
-        /* and push the resulting data */
+        /* and push the resulting data, a view if it's still in the file */
         otmp = newPlofObject();
         otmp->parent = context;
-        otmp->data = (struct PlofData *) retrd;
+        if (prd) {
+            otmp->data = (struct PlofData *) prd;
+        } else if (psl.buf >= rd->data && psl.buf + psl.bufused <= rd->data + rd->length) {
+            otmp->data = (struct PlofData *) plofRawSlice(rd, psl.buf - rd->data, psl.bufused);
+        } else {
+            otmp->data = (struct PlofData *) newPlofRawData(psl.bufused);
+            memcpy(RAW(otmp)->data, psl.buf, psl.bufused);
+        }
+#ifndef PLOF_NO_PARSER
+        if (parsed) plofIncludeParsedPut(rd, brd, crd, RAW(otmp));
+#endif
         STACK_PUSH(otmp);
 
     } else {
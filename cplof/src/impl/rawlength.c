@@ -2,7 +2,7 @@ label(interp_psl_rawlength);
     DEBUG_CMD("rawlength");
     UNARY;
     if (ISRAW(a)) {
-        PUSHINT(RAW(a)->length);
+        PUSHINT(RAWROPE(a)->length);
     } else {
         BADTYPE("rawlength");
         STACK_PUSH(plofNull);
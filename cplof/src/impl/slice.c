@@ -15,9 +15,8 @@ label(interp_psl_slice);
         if (end < start)
             end = start;
 
-        /* start making a new rd */
-        rd = newPlofRawData(end - start);
-        memcpy(rd->data, ra->data + start, rd->length);
+        /* this is usually a view, not a copy */
+        rd = plofRawSlice(ra, start, end - start);
 
         otmp = newPlofObject();
         otmp->parent = context;
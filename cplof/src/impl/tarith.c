@@ -0,0 +1,20 @@
+label(interp_psl_tarith);
+    DEBUG_CMD("tarith");
+    TRINARY;
+    if (ISTYPED(a) && (ISTYPED(b) || ISINT(b)) && ISINT(c)) {
+        int ok;
+
+        /* b is either another array or a value for every element */
+        if (ISINT(b)) {
+            ok = plofTypedArith(TYPED(a), NULL, ASINT(b), ASINT(c));
+        } else {
+            ok = plofTypedArith(TYPED(a), TYPED(b), 0, ASINT(c));
+        }
+
+        if (!ok) {
+            BADTYPE("tarith");
+        }
+    } else {
+        BADTYPE("tarith");
+    }
+    STEP;
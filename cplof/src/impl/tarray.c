@@ -0,0 +1,21 @@
+label(interp_psl_tarray);
+    DEBUG_CMD("tarray");
+    BINARY;
+    if (ISINT(a) && ISINT(b) && ASINT(b) >= 0) {
+        struct PlofTypedData *td;
+        struct PlofObject *otmp;
+
+        td = newPlofTypedData(ASINT(a), ASINT(b));
+        if (td == NULL) {
+            BADTYPE("tarray");
+        }
+
+        otmp = newPlofObject();
+        otmp->parent = context;
+        otmp->data = (struct PlofData *) td;
+        STACK_PUSH(otmp);
+    } else {
+        BADTYPE("tarray");
+        STACK_PUSH(plofNull);
+    }
+    STEP;
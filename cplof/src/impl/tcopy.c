@@ -0,0 +1,45 @@
+label(interp_psl_tcopy);
+    DEBUG_CMD("tcopy");
+    QUINARY;
+    if (ISTYPED(a) && ISINT(b) && (ISTYPED(c) || ISRAW(c)) && ISINT(d) && ISINT(e)) {
+        struct PlofTypedData *td = TYPED(a);
+        ptrdiff_t doff = ASINT(b);
+        ptrdiff_t soff = ASINT(d);
+        ptrdiff_t count = ASINT(e);
+        ptrdiff_t slen;
+
+        /* raw data is copied in as bytes */
+        if (ISRAW(c)) {
+            rd = RAW(c);
+            slen = rd->length;
+        } else {
+            rd = NULL;
+            slen = TYPED(c)->length;
+        }
+
+        /* make sure we're in bounds */
+        if (doff < 0 || soff < 0 || doff > (ptrdiff_t) td->length || soff > slen)
+            count = 0;
+        if (count > (ptrdiff_t) td->length - doff)
+            count = td->length - doff;
+        if (count > slen - soff)
+            count = slen - soff;
+
+        if (count > 0) {
+            if (rd == NULL) {
+                plofTypedCopy(td, doff, TYPED(c), soff, count);
+
+            } else if (td->kind == psl_ctype_uint8) {
+                memmove(td->data + doff, rd->data + soff, count);
+
+            } else {
+                ptrdiff_t i;
+                for (i = 0; i < count; i++)
+                    plofTypedSet(td, doff + i, rd->data[soff + i]);
+
+            }
+        }
+    } else {
+        BADTYPE("tcopy");
+    }
+    STEP;
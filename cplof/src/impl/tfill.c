@@ -0,0 +1,19 @@
+label(interp_psl_tfill);
+    DEBUG_CMD("tfill");
+    QUATERNARY;
+    if (ISTYPED(a) && ISINT(b) && ISINT(c) && ISINT(d)) {
+        struct PlofTypedData *td = TYPED(a);
+        ptrdiff_t start = ASINT(c);
+        ptrdiff_t end = ASINT(d);
+
+        /* make sure we're in bounds */
+        if (start < 0) start = 0;
+        if (end > (ptrdiff_t) td->length) end = td->length;
+
+        if (start < end) {
+            plofTypedFill(td, ASINT(b), start, end);
+        }
+    } else {
+        BADTYPE("tfill");
+    }
+    STEP;
@@ -0,0 +1,17 @@
+label(interp_psl_tindex);
+    DEBUG_CMD("tindex");
+    BINARY;
+    if (ISTYPED(a) && ISINT(b)) {
+        ptrdiff_t index = ASINT(b);
+        struct PlofTypedData *td = TYPED(a);
+
+        if (index < 0 || index >= (ptrdiff_t) td->length) {
+            STACK_PUSH(plofNull);
+        } else {
+            PUSHINT(plofTypedGet(td, index));
+        }
+    } else {
+        BADTYPE("tindex");
+        STACK_PUSH(plofNull);
+    }
+    STEP;
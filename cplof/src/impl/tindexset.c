@@ -0,0 +1,15 @@
+label(interp_psl_tindexset);
+    DEBUG_CMD("tindexset");
+    TRINARY;
+    if (ISTYPED(a) && ISINT(b) && ISINT(c)) {
+        ptrdiff_t index = ASINT(b);
+        struct PlofTypedData *td = TYPED(a);
+
+        /* typed arrays don't grow, so out of bounds is just ignored */
+        if (index >= 0 && index < (ptrdiff_t) td->length) {
+            plofTypedSet(td, index, ASINT(c));
+        }
+    } else {
+        BADTYPE("tindexset");
+    }
+    STEP;
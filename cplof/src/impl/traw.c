@@ -0,0 +1,17 @@
+label(interp_psl_traw);
+    DEBUG_CMD("traw");
+    UNARY;
+    if (ISTYPED(a)) {
+        struct PlofTypedData *td = TYPED(a);
+        struct PlofObject *otmp;
+
+        /* the elements' bytes, in native byte order */
+        otmp = newPlofObjectWithRaw(td->length * td->width);
+        otmp->parent = context;
+        memcpy(RAW(otmp)->data, td->data, td->length * td->width);
+        STACK_PUSH(otmp);
+    } else {
+        BADTYPE("traw");
+        STACK_PUSH(plofNull);
+    }
+    STEP;
@@ -0,0 +1,16 @@
+label(interp_psl_treduce);
+    DEBUG_CMD("treduce");
+    BINARY;
+    if (ISTYPED(a) && ISINT(b)) {
+        ptrdiff_t res;
+
+        if (!plofTypedReduce(TYPED(a), ASINT(b), &res)) {
+            BADTYPE("treduce");
+        }
+
+        PUSHINT(res);
+    } else {
+        BADTYPE("treduce");
+        STACK_PUSH(plofNull);
+    }
+    STEP;
@@ -7,12 +7,10 @@ label(interp_psl_version);
 
 #define CREATE_VERSION(str) \
         { \
-            rd = newPlofRawData(strlen(str)); \
-            memcpy(rd->data, str, rd->length); \
-            \
-            otmp = newPlofObject(); \
+            otmp = newPlofObjectWithRaw(strlen(str)); \
             otmp->parent = context; \
-            otmp->data = (struct PlofData *) rd; \
+            rd = RAW(otmp); \
+            memcpy(rd->data, str, rd->length); \
             \
             ad->data[i++] = otmp; \
         }
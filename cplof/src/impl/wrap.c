@@ -11,7 +11,9 @@ label(interp_psl_wrap);
 
         /* figure out how much space is needed */
         bignumsz = pslBignumLength(ra->length);
-        rd = newPlofRawData(1 + bignumsz + ra->length);
+        otmp = newPlofObjectWithRaw(1 + bignumsz + ra->length);
+        otmp->parent = context;
+        rd = RAW(otmp);
 
         /* copy in the instruction */
         if (rb->length >= 1) {
@@ -25,9 +27,6 @@ label(interp_psl_wrap);
         memcpy(rd->data + 1 + bignumsz, ra->data, ra->length);
 
         /* then push it */
-        otmp = newPlofObject();
-        otmp->parent = context;
-        otmp->data = (struct PlofData *) rd;
         STACK_PUSH(otmp);
 
     } else {
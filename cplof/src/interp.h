@@ -11,6 +11,13 @@ enum PSLCompileLabel {
 };                                                      
 extern void *pslCompileLabels[label_psl_last];             
 
+/* Instruction counts (see plofCountOps), by label, and by pairs of labels.
+ * They're only allocated if counting. plofOpLast is the last instruction
+ * counted */
+extern unsigned long *plofOpCounts;
+extern unsigned long (*plofOpPairCounts)[label_psl_last];
+extern int plofOpLast;
+
 /* The extra data held at the beginning of cpslargs */
 struct CPSLArgsHeader {
     void **cpsl;
@@ -20,4 +27,20 @@ struct CPSLArgsHeader {
 };
 #define CPSL_ARGS_HEADER_LENGTH 4
 
+struct PlofRawData;
+struct PlofReturn;
+
+/* Compile PSL into a series of jumps (interpretPSL does this as needed, and
+ * must have been run once to set up the jump labels) */
+struct PlofReturn compilePSL(
+    size_t psllen,
+    unsigned char *psl,
+    struct PlofRawData *pslrd,
+    int immediate,
+    size_t *cpslalenp,
+    size_t *cpslaip,
+    void **cpslargs,
+    size_t *cpsllenp,
+    void ***cpslargsp);
+
 #endif
@@ -22,6 +22,7 @@
  * THE SOFTWARE.
  */
 
+#include <stdio.h>
 #include <string.h>
 
 #include "impl.h"
@@ -220,7 +221,7 @@ static struct PlofReturn opMember(struct PlofObject *ctx, struct PlofObject *arg
         ret.ret = plofNull;
         return ret;
     }
-    rd = RAW(nameobj);
+    rd = RAWSTR(nameobj);
     name = rd->data;
     namehash = plofHash(rd->length, name);
 
@@ -671,6 +672,1032 @@ static struct PlofReturn opInteger(struct PlofObject *ctx, struct PlofObject *ar
     return ret;
 }
 
+/* arrayAppend. Append the elements of one array to another, in place
+ * PSL code:
+ * {
+ *     // remember the arrays, our position, and how much to copy (which
+ *     // mustn't change if they're the same array)
+ *     this "__pul_aa" push2 0 index memberset
+ *     this "__pul_ab" push2 1 index memberset
+ *     this "__pul_ai" 0 memberset
+ *     this "__pul_an" push2 1 index length memberset
+ *
+ *     null
+ *     {
+ *         this "__pul_ai" resolve member
+ *         this "__pul_an" resolve member
+ *         { global } { null } lt
+ *     }
+ *     {
+ *         // a[a.length] = b[i]
+ *         this "__pul_aa" resolve member
+ *         push0 length
+ *         this "__pul_ab" resolve member
+ *             this "__pul_ai" resolve member
+ *             index
+ *         indexset
+ *
+ *         this "__pul_ai" resolve
+ *             push1 push1 member 1 add
+ *             memberset
+ *     }
+ *     while pop
+ *
+ *     push0 0 index
+ * }
+ */
+static struct PlofReturn arrayAppend(struct PlofObject *ctx, struct PlofObject *arg)
+{
+    struct PlofReturn ret;
+    struct PlofArrayData *ad;
+    ret.isThrown = 0;
+    ret.ret = plofNull;
+
+    /* make sure the arg is right */
+    if (!ISARRAY(arg)) return ret;
+    ad = ARRAY(arg);
+    if (ad->length < 2 || !ISARRAY(ad->data[0]) || !ISARRAY(ad->data[1])) return ret;
+
+    plofArrayAppend(ARRAY(ad->data[0]), ARRAY(ad->data[1]));
+
+    ret.ret = ad->data[0];
+    return ret;
+}
+
+
+/* make a primitive integer */
+static struct PlofObject *newPrimitiveInt(struct PlofObject *ctx, ptrdiff_t val)
+{
+    struct PlofObject *obj;
+#if defined(PLOF_BOX_NUMBERS)
+    obj = newPlofObjectWithRaw(sizeof(ptrdiff_t));
+    obj->parent = ctx;
+#endif
+    SETINT(obj, val);
+    return obj;
+}
+
+/* get the arguments to an intrinsic operating on primitives, evaluated */
+static struct PlofReturn getPrimitiveArgs(struct PlofObject *ctx, struct PlofObject *arg,
+                                          size_t count, struct PlofObject **into)
+{
+    struct PlofReturn ret;
+    struct PlofArrayData *ad;
+    size_t i;
+    ret.isThrown = 0;
+    ret.ret = plofNull;
+
+    if (!ISARRAY(arg)) return ret;
+    ad = ARRAY(arg);
+    if (ad->length < count) return ret;
+
+    for (i = 0; i < count; i++) {
+        ret = pul_eval(ctx, ad->data[i]);
+        if (ret.isThrown) return ret;
+        into[i] = ret.ret;
+    }
+
+    ret.ret = arg;
+    return ret;
+}
+
+/* find needle in haystack at or after from, or -1. memchr for the first byte
+ * is (usually) vectorized, so this only compares at plausible positions */
+static ptrdiff_t rawIndexOf(struct PlofRawData *haystack, struct PlofRawData *needle, size_t from)
+{
+    unsigned char *cur, *end;
+
+    if (needle->length == 0)
+        return (from <= haystack->length) ? (ptrdiff_t) from : -1;
+    if (needle->length > haystack->length)
+        return -1;
+
+    /* the last place the needle could start */
+    end = haystack->data + haystack->length - needle->length + 1;
+
+    for (cur = haystack->data + from; cur < end; cur++) {
+        cur = memchr(cur, needle->data[0], end - cur);
+        if (cur == NULL) break;
+        if (!memcmp(cur + 1, needle->data + 1, needle->length - 1))
+            return cur - haystack->data;
+    }
+
+    return -1;
+}
+
+/* stringIndexOf. Find primitive n in primitive h, starting at primitive f
+ * Plof code:
+ *  (h, n, f) {
+ *      var hs = new String(h)
+ *      var ns = new String(n)
+ *      var hl = hs.length()
+ *      var nl = ns.length()
+ *      var i = opInteger(f)
+ *      var notFound = -1
+ *      if (i < 0) (i = 0)
+ *      if (nl == 0 && i <= hl) (
+ *          return (psl { plof{i.__pul_val} pul_eval })
+ *      )
+ *      while (i + nl <= hl) (
+ *          if (hs.slice(i, i + nl) == ns) (
+ *              return (psl { plof{i.__pul_val} pul_eval })
+ *          )
+ *          i++
+ *      )
+ *      psl { plof{notFound.__pul_val} pul_eval }
+ *  }
+ */
+static struct PlofReturn stringIndexOf(struct PlofObject *ctx, struct PlofObject *arg)
+{
+    struct PlofReturn ret;
+    struct PlofObject *args[3];
+    ptrdiff_t from;
+
+    ret = getPrimitiveArgs(ctx, arg, 3, args);
+    if (ret.isThrown || ret.ret == plofNull) return ret;
+    ret.ret = plofNull;
+    if (!ISRAW(args[0]) || !ISRAW(args[1]) || !ISINT(args[2])) return ret;
+
+    from = ASINT(args[2]);
+    if (from < 0) from = 0;
+
+    ret.ret = newPrimitiveInt(ctx, rawIndexOf(RAW(args[0]), RAW(args[1]), from));
+    return ret;
+}
+
+/* stringSplit. Split primitive s on primitive d, into a primitive array. The
+ * parts are views of s
+ * Plof code:
+ *  (s, d) {
+ *      var ss = new String(s)
+ *      var ds = new String(d)
+ *      var sl = ss.length()
+ *      var dl = ds.length()
+ *      var parts = psl { 0 array }
+ *      var part
+ *      var start = 0
+ *      var i = -1
+ *      if (dl != 0) (i = ss.indexOf(ds))
+ *      while (i != -1) (
+ *          part = ss.slice(start, i)
+ *          parts = psl {
+ *              plof{parts} pul_eval
+ *              plof{part.__pul_val} pul_eval 1 array aconcat
+ *          }
+ *          start = i + dl
+ *          i = ss.indexOfFrom(ds, start)
+ *      )
+ *      part = ""
+ *      if (start < sl) (part = ss.slice(start, sl))
+ *      psl {
+ *          plof{parts} pul_eval
+ *          plof{part.__pul_val} pul_eval 1 array aconcat
+ *      }
+ *  }
+ */
+static struct PlofReturn stringSplit(struct PlofObject *ctx, struct PlofObject *arg)
+{
+    struct PlofReturn ret;
+    struct PlofObject *args[2], *part;
+    struct PlofRawData *rs, *rdl;
+    struct PlofArrayData *ad;
+    size_t count, start, i;
+    ptrdiff_t at;
+
+    ret = getPrimitiveArgs(ctx, arg, 2, args);
+    if (ret.isThrown || ret.ret == plofNull) return ret;
+    ret.ret = plofNull;
+    if (!ISRAW(args[0]) || !ISRAW(args[1])) return ret;
+    rs = RAW(args[0]);
+    rdl = RAW(args[1]);
+
+    /* count the parts first, so the array can be allocated once */
+    count = 1;
+    if (rdl->length) {
+        for (at = rawIndexOf(rs, rdl, 0); at != -1;
+             at = rawIndexOf(rs, rdl, at + rdl->length))
+            count++;
+    }
+
+    ret.ret = newPlofObjectWithArray(count);
+    ret.ret->parent = ctx;
+    ad = ARRAY(ret.ret);
+
+    /* then fill them in */
+    start = 0;
+    for (i = 0; i < count - 1; i++) {
+        at = rawIndexOf(rs, rdl, start);
+        part = newPlofObject();
+        part->parent = ctx;
+        part->data = (struct PlofData *) plofRawSlice(rs, start, at - start);
+        ad->data[i] = part;
+        start = at + rdl->length;
+    }
+    part = newPlofObject();
+    part->parent = ctx;
+    part->data = (struct PlofData *) plofRawSlice(rs, start, rs->length - start);
+    ad->data[i] = part;
+
+    return ret;
+}
+
+/* stringJoin. Join the primitive array a of primitives, separated by the
+ * primitive s
+ * Plof code:
+ *  (a, s) {
+ *      var arr = new Array(a)
+ *      var sep = new String(s)
+ *      var ret = ""
+ *      var el
+ *      for (var i = 0) (i < arr.size()) (i++) (
+ *          if (i != 0) (ret = ret ~ sep)
+ *          el = psl { plof{a} pul_eval plof{i.__pul_val} pul_eval index }
+ *          ret = ret ~ (new String(el))
+ *      )
+ *      psl { plof{ret.__pul_val} pul_eval }
+ *  }
+ */
+static struct PlofReturn stringJoin(struct PlofObject *ctx, struct PlofObject *arg)
+{
+    struct PlofReturn ret;
+    struct PlofObject *args[2];
+    struct PlofArrayData *ad;
+    struct PlofRawData *sep, *el;
+    unsigned char *into;
+    size_t length, i;
+
+    ret = getPrimitiveArgs(ctx, arg, 2, args);
+    if (ret.isThrown || ret.ret == plofNull) return ret;
+    ret.ret = plofNull;
+    if (!ISARRAY(args[0]) || !ISRAW(args[1])) return ret;
+    ad = ARRAY(args[0]);
+    sep = RAW(args[1]);
+    for (i = 0; i < ad->length; i++) {
+        if (!ISRAW(ad->data[i])) return ret;
+    }
+
+    /* figure out how long it'll be */
+    length = 0;
+    for (i = 0; i < ad->length; i++) {
+        if (i) length += sep->length;
+        length += RAW(ad->data[i])->length;
+    }
+
+    /* then copy it all in */
+    ret.ret = newPlofObjectWithRaw(length);
+    ret.ret->parent = ctx;
+    into = RAW(ret.ret)->data;
+    for (i = 0; i < ad->length; i++) {
+        if (i) {
+            memcpy(into, sep->data, sep->length);
+            into += sep->length;
+        }
+        el = RAW(ad->data[i]);
+        memcpy(into, el->data, el->length);
+        into += el->length;
+    }
+
+    return ret;
+}
+
+/* intToString. The decimal representation of the primitive integer i
+ * Plof code:
+ *  (i) {
+ *      var n = opInteger(i)
+ *      var digits = "0123456789"
+ *      var sign = ""
+ *      if (n < 0) (
+ *          sign = "-"
+ *          n = 0 - n
+ *      )
+ *      var d = n % 10
+ *      var str = digits.slice(d, d + 1)
+ *      n = n / 10
+ *      while (n != 0) (
+ *          d = n % 10
+ *          str = digits.slice(d, d + 1) ~ str
+ *          n = n / 10
+ *      )
+ *      str = sign ~ str
+ *      psl { plof{str.__pul_val} pul_eval }
+ *  }
+ */
+static struct PlofReturn intToString(struct PlofObject *ctx, struct PlofObject *arg)
+{
+    struct PlofReturn ret;
+    struct PlofObject *args[1];
+    char buf[3 * sizeof(ptrdiff_t) + 2];
+    size_t length;
+
+    ret = getPrimitiveArgs(ctx, arg, 1, args);
+    if (ret.isThrown || ret.ret == plofNull) return ret;
+    ret.ret = plofNull;
+    if (!ISINT(args[0])) return ret;
+
+    length = sprintf(buf, "%ld", (long) ASINT(args[0]));
+    ret.ret = newPlofObjectWithRaw(length);
+    ret.ret->parent = ctx;
+    memcpy(RAW(ret.ret)->data, buf, length);
+
+    return ret;
+}
+
+/* stringToInt. The integer value of the decimal primitive s: an optional
+ * sign, then digits up to the first non-digit. A magnitude too big for an
+ * integer saturates at the largest one
+ * Plof code:
+ *  (s) {
+ *      var ss = new String(s)
+ *      var sl = ss.length()
+ *      var i = 0
+ *      var neg = False
+ *      var val = 0
+ *      var c
+ *      var next
+ *      if (sl > 0) (
+ *          c = ss.charCodeAt(0)
+ *          if (c == 45) (
+ *              neg = True
+ *              i = 1
+ *          ) else if (c == 43) (
+ *              i = 1
+ *          )
+ *      )
+ *      while (i < sl) (
+ *          c = ss.charCodeAt(i)
+ *          if (c < 48) (break())
+ *          if (c > 57) (break())
+ *          next = val * 10 + (c - 48)
+ *          if (next < val || (next - (c - 48)) / 10 != val) (
+ *              val = 1
+ *              while (val * 2 + 1 > val) (val = val * 2 + 1)
+ *              break()
+ *          )
+ *          val = next
+ *          i++
+ *      )
+ *      if (neg) (val = 0 - val)
+ *      psl { plof{val.__pul_val} pul_eval }
+ *  }
+ */
+static struct PlofReturn stringToInt(struct PlofObject *ctx, struct PlofObject *arg)
+{
+    struct PlofReturn ret;
+    struct PlofObject *args[1];
+    struct PlofRawData *rs;
+    ptrdiff_t val = 0;
+    size_t i = 0;
+    int neg = 0;
+
+    ret = getPrimitiveArgs(ctx, arg, 1, args);
+    if (ret.isThrown || ret.ret == plofNull) return ret;
+    ret.ret = plofNull;
+    if (!ISRAW(args[0])) return ret;
+    rs = RAW(args[0]);
+
+    if (rs->length > 0) {
+        if (rs->data[0] == '-') {
+            neg = 1;
+            i = 1;
+        } else if (rs->data[0] == '+') {
+            i = 1;
+        }
+    }
+    for (; i < rs->length && rs->data[i] >= '0' && rs->data[i] <= '9'; i++) {
+        int digit = rs->data[i] - '0';
+        if (val > (PLOF_INT_MAX - digit) / 10) {
+            val = PLOF_INT_MAX;
+            break;
+        }
+        val = val * 10 + digit;
+    }
+    if (neg) val = -val;
+
+    ret.ret = newPrimitiveInt(ctx, val);
+    return ret;
+}
+
+
+/* eachMember. Call f with [name, value] for each member of obj, walking its
+ * hash table in place. Members added by f may or may not be visited
+ * PSL code:
+ * {
+ *     this "__pul_mo" push2 0 index memberset
+ *     this "__pul_mf" push2 1 index memberset
+ *     this "__pul_mm" push2 0 index members memberset
+ *     this "__pul_mi" 0 memberset
+ *
+ *     null
+ *     {
+ *         this "__pul_mi" resolve member
+ *         this "__pul_mm" resolve member length
+ *         { global } { null } lt
+ *     }
+ *     {
+ *         // f([name, obj.name])
+ *         this "__pul_mm" resolve member
+ *             this "__pul_mi" resolve member
+ *             index
+ *         this "__pul_mo" resolve member
+ *             push1 member
+ *         2 array
+ *         this "__pul_mf" resolve member
+ *         call pop
+ *
+ *         this "__pul_mi" resolve
+ *             push1 push1 member 1 add
+ *             memberset
+ *     }
+ *     while pop
+ *
+ *     null
+ * }
+ */
+static struct PlofReturn eachMember(struct PlofObject *ctx, struct PlofObject *arg)
+{
+    struct PlofReturn ret;
+    struct PlofObject *args[2], *obj, *f, *farg;
+    struct PlofArrayData *fad;
+    struct PlofOHashTable *cur;
+    int i;
+
+    ret = getPrimitiveArgs(ctx, arg, 2, args);
+    if (ret.isThrown || ret.ret == plofNull) return ret;
+    ret.ret = plofNull;
+    obj = args[0];
+    f = args[1];
+    if (!ISOBJ(obj) || !ISRAW(f) || !obj->hashTable) return ret;
+
+    for (i = 0; i < PLOF_HASHTABLE_SIZE; i++) {
+        for (cur = &obj->hashTable->elems[i]; cur && cur->name; cur = cur->next) {
+            farg = newPlofObjectWithArray(2);
+            farg->parent = ctx;
+            fad = ARRAY(farg);
+            fad->data[0] = plofMemberName(cur->name, cur->hashedName);
+            fad->data[1] = cur->value;
+
+            ret = interpretPSL(f->parent, farg, f, 0, NULL, 1, 0);
+            if (ret.isThrown) return ret;
+        }
+    }
+
+    ret.ret = plofNull;
+    return ret;
+}
+
+
+
+/* call the function f with the given arguments, and evaluate what it returns */
+static struct PlofReturn callFunction(struct PlofObject *ctx, struct PlofObject *f,
+                                      size_t argc, struct PlofObject *a0, struct PlofObject *a1)
+{
+    struct PlofReturn ret;
+    struct PlofObject *farg;
+    struct PlofArrayData *fad;
+
+    farg = newPlofObjectWithArray(argc);
+    farg->parent = ctx;
+    fad = ARRAY(farg);
+    fad->data[0] = a0;
+    if (argc > 1) fad->data[1] = a1;
+
+    ret = interpretPSL(f->parent, farg, f, 0, NULL, 1, 0);
+    if (ret.isThrown) return ret;
+    return pul_eval(ctx, ret.ret);
+}
+
+/* arrayIndex. A by-ref wrapper for element i of primitive array a. Nothing is
+ * read until it's evaluated. The wrapper's data is [a, i], and its __pul_e
+ * and __pul_s share their (intrinsic) code between all wrappers
+ * PSL code:
+ * {
+ *     this "__pul_aa" push2 0 index memberset
+ *     this "__pul_ai" push2 1 index memberset
+ *
+ *     new
+ *
+ *     push0 "__pul_e"
+ *     {
+ *         this "__pul_aa" resolve member
+ *         this "__pul_ai" resolve member
+ *         index
+ *     } memberset
+ *
+ *     push0 "__pul_s"
+ *     {
+ *         this "__pul_aa" resolve member
+ *         this "__pul_ai" resolve member
+ *         push2
+ *         indexset
+ *     } memberset
+ * }
+ */
+static struct PlofReturn arrayIndex_e(struct PlofObject *ctx, struct PlofObject *arg);
+static struct PlofReturn arrayIndex_s(struct PlofObject *ctx, struct PlofObject *arg);
+static struct PlofReturn arrayIndex(struct PlofObject *ctx, struct PlofObject *arg)
+{
+    struct PlofReturn ret;
+    struct PlofObject *args[2], *wrapper, *pul_e, *pul_s;
+    struct PlofArrayData *wad;
+    static struct PlofRawData *pul_e_raw = NULL;
+    static struct PlofRawData *pul_s_raw = NULL;
+
+    GET_HASHES;
+
+    ret = getPrimitiveArgs(ctx, arg, 2, args);
+    if (ret.isThrown || ret.ret == plofNull) return ret;
+    ret.ret = plofNull;
+    if (!ISARRAY(args[0]) || !ISINT(args[1])) return ret;
+
+    /* the wrapper remembers what it refers to */
+    wrapper = newPlofObjectWithArray(2);
+    wrapper->parent = ctx;
+    wad = ARRAY(wrapper);
+    wad->data[0] = args[0];
+    wad->data[1] = args[1];
+
+    /* make pul_e */
+    pul_e = newPlofObject();
+    pul_e->parent = wrapper;
+    if (pul_e_raw == NULL) {
+        pul_e_raw = newPlofRawData(1);
+        pul_e_raw->proc = arrayIndex_e;
+    }
+    pul_e->data = (struct PlofData *) pul_e_raw;
+    plofWrite(wrapper, (unsigned char *) "__pul_e", __pul_e_hash, pul_e);
+
+    /* and pul_s */
+    pul_s = newPlofObject();
+    pul_s->parent = wrapper;
+    if (pul_s_raw == NULL) {
+        pul_s_raw = newPlofRawData(1);
+        pul_s_raw->proc = arrayIndex_s;
+    }
+    pul_s->data = (struct PlofData *) pul_s_raw;
+    plofWrite(wrapper, (unsigned char *) "__pul_s", __pul_s_hash, pul_s);
+
+    ret.ret = wrapper;
+    return ret;
+}
+
+static struct PlofReturn arrayIndex_e(struct PlofObject *ctx, struct PlofObject *arg)
+{
+    struct PlofReturn ret;
+    struct PlofArrayData *ad;
+    ptrdiff_t index;
+    ret.isThrown = 0;
+    ret.ret = plofNull;
+
+    ad = ARRAY(ARRAY(ctx)->data[0]);
+    index = ASINT(ARRAY(ctx)->data[1]);
+    if (index >= 0 && index < (ptrdiff_t) ad->length)
+        ret.ret = ad->data[index];
+
+    return ret;
+}
+
+static struct PlofReturn arrayIndex_s(struct PlofObject *ctx, struct PlofObject *arg)
+{
+    struct PlofReturn ret;
+    struct PlofArrayData *ad;
+    ptrdiff_t index;
+    ret.isThrown = 0;
+    ret.ret = plofNull;
+
+    ad = ARRAY(ARRAY(ctx)->data[0]);
+    index = ASINT(ARRAY(ctx)->data[1]);
+    if (index >= (ptrdiff_t) ad->length)
+        plofArrayResize(ad, index + 1);
+    if (index >= 0)
+        ad->data[index] = arg;
+
+    return ret;
+}
+
+/* arrayEach. Call f with [a[i]] for each element of primitive array a
+ * PSL code:
+ * {
+ *     this "__pul_aa" push2 0 index memberset
+ *     this "__pul_af" push2 1 index memberset
+ *     this "__pul_ai" 0 memberset
+ *
+ *     null
+ *     {
+ *         this "__pul_ai" resolve member
+ *         this "__pul_aa" resolve member length
+ *         { global } { null } lt
+ *     }
+ *     {
+ *         // f([a[i]])
+ *         this "__pul_aa" resolve member
+ *             this "__pul_ai" resolve member
+ *             index
+ *         1 array
+ *         this "__pul_af" resolve member
+ *         call pop
+ *
+ *         this "__pul_ai" resolve
+ *             push1 push1 member 1 add
+ *             memberset
+ *     }
+ *     while pop
+ *
+ *     null
+ * }
+ */
+static struct PlofReturn arrayEach(struct PlofObject *ctx, struct PlofObject *arg)
+{
+    struct PlofReturn ret;
+    struct PlofObject *args[2];
+    struct PlofArrayData *ad;
+    size_t i;
+
+    ret = getPrimitiveArgs(ctx, arg, 2, args);
+    if (ret.isThrown || ret.ret == plofNull) return ret;
+    ret.ret = plofNull;
+    if (!ISARRAY(args[0]) || !ISRAW(args[1])) return ret;
+    ad = ARRAY(args[0]);
+
+    /* f may change the array, so its length is checked every time */
+    for (i = 0; i < ad->length; i++) {
+        ret = callFunction(ctx, args[1], 1, ad->data[i], NULL);
+        if (ret.isThrown) return ret;
+    }
+
+    ret.ret = plofNull;
+    return ret;
+}
+
+/* arrayMap. A new primitive array of f([a[i]]) for each element of a
+ * PSL code:
+ * {
+ *     this "__pul_aa" push2 0 index memberset
+ *     this "__pul_af" push2 1 index memberset
+ *     this "__pul_ai" 0 memberset
+ *     this "__pul_ar" push2 0 index length nullarray memberset
+ *
+ *     null
+ *     {
+ *         this "__pul_ai" resolve member
+ *         this "__pul_ar" resolve member length
+ *         { global } { null } lt
+ *     }
+ *     {
+ *         // r[i] = f([a[i]])
+ *         this "__pul_ar" resolve member
+ *         this "__pul_ai" resolve member
+ *             this "__pul_aa" resolve member
+ *                 this "__pul_ai" resolve member
+ *                 index
+ *             1 array
+ *             this "__pul_af" resolve member
+ *             call pul_eval
+ *         indexset
+ *
+ *         this "__pul_ai" resolve
+ *             push1 push1 member 1 add
+ *             memberset
+ *     }
+ *     while pop
+ *
+ *     this "__pul_ar" resolve member
+ * }
+ */
+static struct PlofReturn arrayMap(struct PlofObject *ctx, struct PlofObject *arg)
+{
+    struct PlofReturn ret;
+    struct PlofObject *args[2], *res;
+    struct PlofArrayData *ad, *rad;
+    size_t i;
+
+    ret = getPrimitiveArgs(ctx, arg, 2, args);
+    if (ret.isThrown || ret.ret == plofNull) return ret;
+    ret.ret = plofNull;
+    if (!ISARRAY(args[0]) || !ISRAW(args[1])) return ret;
+    ad = ARRAY(args[0]);
+
+    res = newPlofObjectWithArray(ad->length);
+    res->parent = ctx;
+    rad = ARRAY(res);
+    for (i = 0; i < rad->length; i++)
+        rad->data[i] = plofNull;
+
+    for (i = 0; i < rad->length && i < ad->length; i++) {
+        ret = callFunction(ctx, args[1], 1, ad->data[i], NULL);
+        if (ret.isThrown) return ret;
+        rad->data[i] = ret.ret;
+    }
+
+    ret.ret = res;
+    return ret;
+}
+
+/* arrayApply. Replace each element of primitive array a with f([a[i]])
+ * PSL code:
+ * {
+ *     this "__pul_aa" push2 0 index memberset
+ *     this "__pul_af" push2 1 index memberset
+ *     this "__pul_ai" 0 memberset
+ *
+ *     null
+ *     {
+ *         this "__pul_ai" resolve member
+ *         this "__pul_aa" resolve member length
+ *         { global } { null } lt
+ *     }
+ *     {
+ *         // a[i] = f([a[i]])
+ *         this "__pul_aa" resolve member
+ *         this "__pul_ai" resolve member
+ *             push1 push1 index
+ *             1 array
+ *             this "__pul_af" resolve member
+ *             call pul_eval
+ *         indexset
+ *
+ *         this "__pul_ai" resolve
+ *             push1 push1 member 1 add
+ *             memberset
+ *     }
+ *     while pop
+ *
+ *     this "__pul_aa" resolve member
+ * }
+ */
+static struct PlofReturn arrayApply(struct PlofObject *ctx, struct PlofObject *arg)
+{
+    struct PlofReturn ret;
+    struct PlofObject *args[2];
+    struct PlofArrayData *ad;
+    size_t i;
+
+    ret = getPrimitiveArgs(ctx, arg, 2, args);
+    if (ret.isThrown || ret.ret == plofNull) return ret;
+    ret.ret = plofNull;
+    if (!ISARRAY(args[0]) || !ISRAW(args[1])) return ret;
+    ad = ARRAY(args[0]);
+
+    for (i = 0; i < ad->length; i++) {
+        ret = callFunction(ctx, args[1], 1, ad->data[i], NULL);
+        if (ret.isThrown) return ret;
+        if (i < ad->length) ad->data[i] = ret.ret;
+    }
+
+    ret.ret = args[0];
+    return ret;
+}
+
+/* arrayFold. Fold f([acc, a[i]]) over primitive array a, starting from init
+ * PSL code:
+ * {
+ *     this "__pul_aa" push2 0 index memberset
+ *     this "__pul_ac" push2 1 index memberset
+ *     this "__pul_af" push2 2 index memberset
+ *     this "__pul_ai" 0 memberset
+ *
+ *     null
+ *     {
+ *         this "__pul_ai" resolve member
+ *         this "__pul_aa" resolve member length
+ *         { global } { null } lt
+ *     }
+ *     {
+ *         // acc = f([acc, a[i]])
+ *         this "__pul_ac" resolve
+ *             push1 push1 member
+ *             this "__pul_aa" resolve member
+ *                 this "__pul_ai" resolve member
+ *                 index
+ *             2 array
+ *             this "__pul_af" resolve member
+ *             call pul_eval
+ *         memberset
+ *
+ *         this "__pul_ai" resolve
+ *             push1 push1 member 1 add
+ *             memberset
+ *     }
+ *     while pop
+ *
+ *     this "__pul_ac" resolve member
+ * }
+ */
+static struct PlofReturn arrayFold(struct PlofObject *ctx, struct PlofObject *arg)
+{
+    struct PlofReturn ret;
+    struct PlofObject *args[3], *acc;
+    struct PlofArrayData *ad;
+    size_t i;
+
+    ret = getPrimitiveArgs(ctx, arg, 3, args);
+    if (ret.isThrown || ret.ret == plofNull) return ret;
+    ret.ret = plofNull;
+    if (!ISARRAY(args[0]) || !ISRAW(args[2])) return ret;
+    ad = ARRAY(args[0]);
+
+    acc = args[1];
+    for (i = 0; i < ad->length; i++) {
+        ret = callFunction(ctx, args[2], 2, acc, ad->data[i]);
+        if (ret.isThrown) return ret;
+        acc = ret.ret;
+    }
+
+    ret.ret = acc;
+    return ret;
+}
+
+
+/* an element being sorted, with its key if it has a primitive one */
+struct SortEntry {
+    struct PlofObject *obj;
+    ptrdiff_t ikey;
+    struct PlofRawData *rkey;
+};
+
+/* how arraySort is comparing */
+struct SortState {
+    int mode; /* 0 for integer keys, 1 for raw keys, 2 for calling f */
+    struct PlofObject *ctx, *f;
+    struct PlofReturn ret;
+    int thrown;
+};
+
+static ptrdiff_t sortCompare(struct SortState *st, struct SortEntry *a, struct SortEntry *b)
+{
+    struct PlofObject *res;
+    size_t shorter;
+    int c;
+
+    switch (st->mode) {
+        case 0:
+            return (a->ikey > b->ikey) - (a->ikey < b->ikey);
+
+        case 1:
+            shorter = a->rkey->length;
+            if (b->rkey->length < shorter) shorter = b->rkey->length;
+            c = memcmp(a->rkey->data, b->rkey->data, shorter);
+            if (c) return c;
+            return (a->rkey->length > b->rkey->length) - (a->rkey->length < b->rkey->length);
+
+        default:
+            if (st->thrown) return 0;
+            st->ret = callFunction(st->ctx, st->f, 2, a->obj, b->obj);
+            if (st->ret.isThrown) {
+                st->thrown = 1;
+                return 0;
+            }
+            res = plofRead(st->ret.ret, (unsigned char *) "__pul_val", __pul_val_hash);
+            return ISINT(res) ? ASINT(res) : 0;
+    }
+}
+
+/* stable merge sort of entries, using tmp (as long as entries) for merging */
+static void sortEntries(struct SortState *st, struct SortEntry *entries,
+                        struct SortEntry *tmp, size_t length)
+{
+    size_t mid, i, j, k;
+
+    /* short runs are insertion sorted */
+    if (length <= 8) {
+        for (i = 1; i < length; i++) {
+            struct SortEntry cur = entries[i];
+            for (j = i; j > 0 && sortCompare(st, entries + j - 1, &cur) > 0; j--)
+                entries[j] = entries[j-1];
+            entries[j] = cur;
+        }
+        return;
+    }
+
+    mid = length / 2;
+    sortEntries(st, entries, tmp, mid);
+    sortEntries(st, entries + mid, tmp, length - mid);
+    if (st->thrown) return;
+
+    /* already in order? */
+    if (sortCompare(st, entries + mid - 1, entries + mid) <= 0) return;
+
+    memcpy(tmp, entries, mid * sizeof(struct SortEntry));
+    i = 0; j = mid; k = 0;
+    while (i < mid && j < length) {
+        if (sortCompare(st, entries + j, tmp + i) < 0) {
+            entries[k++] = entries[j++];
+        } else {
+            entries[k++] = tmp[i++];
+        }
+    }
+    while (i < mid) entries[k++] = tmp[i++];
+}
+
+/* the type an object was made directly from (by new), or NULL */
+static struct PlofObject *sortTypeOf(struct PlofObject *obj)
+{
+    struct PlofObject *pul_type_obj;
+
+    pul_type_obj = plofRead(obj, (unsigned char *) "__pul_type", __pul_type_hash);
+    if (pul_type_obj == plofNull || !ISARRAY(pul_type_obj) || ARRAY(pul_type_obj)->length < 2)
+        return NULL;
+    return ARRAY(pul_type_obj)->data[1];
+}
+
+/* arraySort. Stably sort primitive array a in place. natural may be the
+ * primitive array [NativeInteger, String]: if the elements are all made
+ * directly from the one or all from the other, they're compared by their
+ * values, as those types' opCmp would. Otherwise (including for any subtype,
+ * which may override opCmp), f([x, y]) gives their order as a NativeInteger
+ * Plof code:
+ *  (a, f, natural) {
+ *      var l = opInteger(psl { plof{a} pul_eval length })
+ *      var i
+ *      var j
+ *      var x
+ *      var y
+ *      for (i = 1) (i < l) (i++) (
+ *          x = psl { plof{a} pul_eval plof{i.__pul_val} pul_eval index }
+ *          j = i - 1
+ *          while (j >= 0) (
+ *              y = psl { plof{a} pul_eval plof{j.__pul_val} pul_eval index }
+ *              if (f(y, x) <= 0) (break())
+ *              psl {
+ *                  plof{a} pul_eval plof{j.__pul_val} pul_eval 1 add
+ *                  plof{y} pul_eval indexset
+ *              }
+ *              j = j - 1
+ *          )
+ *          psl {
+ *              plof{a} pul_eval plof{j.__pul_val} pul_eval 1 add
+ *              plof{x} pul_eval indexset
+ *          }
+ *      )
+ *      a
+ *  }
+ */
+static struct PlofReturn arraySort(struct PlofObject *ctx, struct PlofObject *arg)
+{
+    struct PlofReturn ret;
+    struct PlofObject *args[3], *val, *intType, *strType, *type;
+    struct PlofArrayData *ad;
+    struct SortEntry *entries, *tmp;
+    struct SortState st;
+    size_t length, i, ints, raws;
+
+    GET_HASHES;
+
+    ret = getPrimitiveArgs(ctx, arg, 3, args);
+    if (ret.isThrown || ret.ret == plofNull) return ret;
+    ret.ret = plofNull;
+    if (!ISARRAY(args[0]) || !ISRAW(args[1])) return ret;
+    ad = ARRAY(args[0]);
+    length = ad->length;
+
+    intType = strType = NULL;
+    if (ISARRAY(args[2]) && ARRAY(args[2])->length == 2) {
+        intType = ARRAY(args[2])->data[0];
+        strType = ARRAY(args[2])->data[1];
+    }
+
+    /* get the elements and the primitive keys of those of the natural types */
+    entries = (struct SortEntry *) GC_MALLOC(length * sizeof(struct SortEntry));
+    tmp = (struct SortEntry *) GC_MALLOC((length / 2 + 1) * sizeof(struct SortEntry));
+    ints = raws = 0;
+    for (i = 0; i < length; i++) {
+        ret = pul_eval(ctx, ad->data[i]);
+        if (ret.isThrown) return ret;
+        entries[i].obj = ret.ret;
+        if (!intType || !ISOBJ(ret.ret)) continue;
+
+        type = sortTypeOf(ret.ret);
+        if (type != intType && type != strType) continue;
+        val = plofRead(ret.ret, (unsigned char *) "__pul_val", __pul_val_hash);
+        if (type == intType && ISINT(val)) {
+            entries[i].ikey = ASINT(val);
+            ints++;
+        } else if (type == strType && ISRAW(val)) {
+            entries[i].rkey = RAW(val);
+            raws++;
+        }
+    }
+
+    st.ctx = ctx;
+    st.f = args[1];
+    st.thrown = 0;
+    if (intType && ints == length) {
+        st.mode = 0;
+    } else if (intType && raws == length) {
+        st.mode = 1;
+    } else {
+        st.mode = 2;
+    }
+
+    sortEntries(&st, entries, tmp, length);
+    if (st.thrown) return st.ret;
+
+    /* f could have shortened the array */
+    for (i = 0; i < length && i < ad->length; i++)
+        ad->data[i] = entries[i].obj;
+
+    ret.ret = args[0];
+    return ret;
+}
 
 /* the intrinsics list */
 PlofFunction plofIntrinsics[] = {
@@ -682,5 +1709,35 @@ PlofFunction plofIntrinsics[] = {
     opDuplicate,        /* 5 */
     set__pul_icache,
     setNativeInteger,
-    opInteger
+    opInteger,
+    arrayAppend,
+    stringIndexOf,      /* 10 */
+    stringSplit,
+    stringJoin,
+    intToString,
+    stringToInt,
+    eachMember,         /* 15 */
+    arrayIndex,
+    arrayEach,
+    arrayMap,
+    arrayApply,
+    arrayFold,          /* 20 */
+    arraySort
+};
+size_t plofIntrinsicCount = sizeof(plofIntrinsics) / sizeof(PlofFunction);
+
+/* the helpers list */
+PlofFunction plofIntrinsicHelpers[] = {
+    pul_funcwrap_e,
+    pul_funcwrap_s,
+    arrayIndex_e,
+    arrayIndex_s
+};
+size_t plofIntrinsicHelperCount = sizeof(plofIntrinsicHelpers) / sizeof(PlofFunction);
+
+/* and the roots */
+struct PlofObject **plofIntrinsicRoots[] = {
+    &__pul_icache,
+    &NativeInteger
 };
+size_t plofIntrinsicRootCount = sizeof(plofIntrinsicRoots) / sizeof(struct PlofObject **);
@@ -29,5 +29,15 @@
 
 /* the array of intrinsic operations */
 extern PlofFunction plofIntrinsics[];
+extern size_t plofIntrinsicCount;
+
+/* the procedures of closures made by intrinsics, which aren't intrinsics
+ * themselves but may be found in the heap */
+extern PlofFunction plofIntrinsicHelpers[];
+extern size_t plofIntrinsicHelperCount;
+
+/* the objects the intrinsics hold on to */
+extern struct PlofObject **plofIntrinsicRoots[];
+extern size_t plofIntrinsicRootCount;
 
 #endif
@@ -23,39 +23,93 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
+#ifdef HAVE_CONFIG_H
+#include "../config.h"
+#else
+#include "basicconfig.h"
+#endif
+
 #include "plof/bignum.h"
+#include "plof/bundle.h"
+#include "plof/image.h"
 #include "plof/memory.h"
 #include "plof/packrat.h"
 #include "plof/plof.h"
+#include "plof/profile.h"
 #include "plof/prp.h"
 #include "plof/psl.h"
 #include "plof/pslfile.h"
+#include "pslopt.h"
 #include "whereami.h"
 
+#ifdef HAVE_UNISTD_H
+#include <sys/resource.h>
+#include <sys/stat.h>
+#endif
+
+#define BUFFER_GC
+#include "plof/buffer.h"
+BUFFER(BundleFile, struct PlofBundleFile);
+
 #define BUFSTEP 1024
 #define MAX_FILES 32
 
 #define ARG(LONG, SHORT) if(!strcmp(argv[argn], "--" LONG) || !strcmp(argv[argn], "-" SHORT))
 void usage();
+FILE *openOnPath(char *name);
+int writeBundle(char *bundleFile, char *wdir, struct Buffer_BundleFile *bundle,
+                struct Buffer_psl app);
+
+/* write out the parse profile at exit */
+static int parseProfileJSON = 0;
+static void parseProfileReport()
+{
+    packratProfileReport(stderr, parseProfileJSON);
+}
+
+/* write out memory statistics at exit (for bench/) */
+static void statsReport()
+{
+#ifdef HAVE_UNISTD_H
+    struct rusage ru;
+#endif
+
+    fprintf(stderr, "gc-collections %lu\n", (unsigned long) GC_get_gc_no());
+    fprintf(stderr, "gc-heap-bytes %lu\n", (unsigned long) GC_get_heap_size());
+#ifdef HAVE_UNISTD_H
+    if (getrusage(RUSAGE_SELF, &ru) == 0)
+        fprintf(stderr, "peak-rss-kb %ld\n", (long) ru.ru_maxrss);
+#endif
+}
 
 int main(int argc, char **argv)
 {
     FILE *fh;
     char *wdir, *wfil;
-    unsigned char **path;
     struct Buffer_psl file;
 
     char *files[MAX_FILES+1];
+    char *includeDirs[MAX_FILES+1];
+    int includeDirCount;
 
-    struct PlofObject *context;
+    struct PlofObject *context, *pslobj;
 
-    int fn, argn, compileOnly, interactive;
+    int fn, argn, compileOnly, interactive, optimize;
 
     struct Buffer_psl compileBuf;
     char *compileFile;
 
+    char *imageFile, *saveImageFile;
+    size_t stdHash;
+
+    char *profileFile;
+
+    char *bundleFile;
+    struct Buffer_BundleFile bundle;
+
     struct PlofReturn plofRet;
 
     int plofargc;
@@ -67,10 +121,17 @@ int main(int argc, char **argv)
     files[0] = "std.psl";
     fn = 1;
     compileOnly = 0;
+    optimize = 0;
     compileFile = "a.psl";
     interactive = 0;
     plofargc = 0;
     plofargv = NULL;
+    imageFile = saveImageFile = NULL;
+    stdHash = 0;
+    bundleFile = NULL;
+    profileFile = getenv("PLOF_PROFILE");
+    if (getenv("PLOF_COUNT_OPS")) plofCountOps = 1;
+    includeDirCount = 0;
 
     /* handle args */
     for (argn = 1; argn < argc; argn++) {
@@ -84,18 +145,56 @@ int main(int argc, char **argv)
             compileOnly = 1;
             compileFile = argv[++argn];
 
+        } else ARG("optimize", "O") {
+            optimize = 1;
+
+        } else ARG("include-path", "I") {
+            if (includeDirCount >= MAX_FILES) {
+                fprintf(stderr, "Too many include paths!\n");
+                return 1;
+            }
+            includeDirs[includeDirCount++] = argv[++argn];
+
         } else ARG("debug", "g") {
             prpDebug = 1;
 
         } else ARG("interactive", "i") {
             interactive = 1;
 
+        } else ARG("image", "\xFF") {
+            /* the image has std.psl loaded already */
+            files[0] = NULL;
+            imageFile = argv[++argn];
+
+        } else ARG("bundle", "\xFF") {
+            compileOnly = 1;
+            bundleFile = argv[++argn];
+
+        } else ARG("save-image", "\xFF") {
+            saveImageFile = argv[++argn];
+
         } else ARG("no-intrinsics", "\xFF") {
             plofLoadIntrinsics = 0;
 
         } else ARG("warn-ambiguous", "\xFF") {
             packratWarnAmbiguous = 1;
 
+        } else ARG("profile", "\xFF") {
+            profileFile = argv[++argn];
+
+        } else ARG("stats", "\xFF") {
+            atexit(statsReport);
+
+        } else ARG("count-ops", "\xFF") {
+            plofCountOps = 1;
+
+        } else ARG("parse-profile", "\xFF") {
+            packratProfile = 1;
+
+        } else ARG("parse-profile-json", "\xFF") {
+            packratProfile = 1;
+            parseProfileJSON = 1;
+
         } else ARG("help", "h") {
             usage();
             return 0;
@@ -110,7 +209,7 @@ int main(int argc, char **argv)
             if (fn >= MAX_FILES) {
                 fprintf(stderr, "Too many files!\n");
                 return 1;
-            } else if (files[0] && !compileOnly && fn >= 2) {
+            } else if ((files[0] || imageFile) && !compileOnly && !saveImageFile && fn >= 2) {
                 /* we have an input file, we're not compiling, so the rest is Plof args */
                 argn++;
                 plofargc = argc - argn;
@@ -122,15 +221,33 @@ int main(int argc, char **argv)
     }
     files[fn] = NULL;
 
+    if (packratProfile)
+        atexit(parseProfileReport);
+
+    if (profileFile) {
+        if (!plofProfileStart(profileFile))
+            return 1;
+        atexit(plofProfileStop);
+    }
+
+    if (plofCountOps)
+        atexit(plofCountReport);
+
     /* get our search path */
     if (whereAmI(argv[0], &wdir, &wfil)) {
-        int onIncPath = 0;
+        int onIncPath = 0, i;
 
-        plofIncludePaths = GC_MALLOC(16 * sizeof(unsigned char *));
+        plofIncludePaths = GC_MALLOC((includeDirCount + 16) * sizeof(unsigned char *));
 
         plofIncludePaths[onIncPath] = GC_MALLOC_ATOMIC(3);
         sprintf((char *) plofIncludePaths[onIncPath++], "./");
 
+        /* -I */
+        for (i = 0; i < includeDirCount; i++) {
+            plofIncludePaths[onIncPath] = GC_MALLOC_ATOMIC(strlen(includeDirs[i]) + 2);
+            sprintf((char *) plofIncludePaths[onIncPath++], "%s/", includeDirs[i]);
+        }
+
         if (prpDebug) {
             plofIncludePaths[onIncPath] = GC_MALLOC_ATOMIC(strlen(wdir) + 30);
             sprintf((char *) plofIncludePaths[onIncPath++], "%s/../share/plof_include/debug/", wdir);
@@ -149,8 +266,6 @@ int main(int argc, char **argv)
 
         plofIncludePaths[onIncPath] = NULL;
 
-        /* FIXME: should support -I eventually */
-
     } else {
         fprintf(stderr, "Could not deterine include paths!\n");
         return 1;
@@ -158,25 +273,71 @@ int main(int argc, char **argv)
     }
 
     /* complain if there aren't any files */
-    if (fn == 1 && !interactive) {
+    if (fn == 1 && !interactive && !saveImageFile) {
         usage();
         return 1;
     }
     /* FIXME: should be in if (compileOnly), but -Wall complains */
     INIT_ATOMIC_BUFFER(compileBuf);
+    INIT_BUFFER(bundle);
     
-    /* Initialize null and global */
-    plofNull = newPlofObject();
-    plofNull->parent = plofNull;
-    plofGlobal = newPlofObject();
-    plofGlobal->parent = plofGlobal;
+    if (imageFile) {
+        struct Buffer_psl grammar;
+
+        /* null, global and the context all come from the image */
+        fh = openOnPath(imageFile);
+        if (fh == NULL) {
+            perror(imageFile);
+            return 1;
+        }
+        file.buf = pslLoadFile(fh, &file.bufused);
+        fclose(fh);
+
+        /* it has to have been made with the std.psl we'd otherwise load */
+        fh = openOnPath("std.psl");
+        if (fh) {
+            struct Buffer_psl std;
+            std.buf = pslLoadFile(fh, &std.bufused);
+            fclose(fh);
+            stdHash = plofHash(std.bufused, std.buf);
+        }
+
+        context = plofReadImage(file.bufused, file.buf, stdHash, &grammar);
+        if (context == NULL) return 1;
+        prpReplayGrammar(grammar.bufused, grammar.buf);
+
+    } else {
+        /* Initialize null and global */
+        plofNull = newPlofObject();
+        plofNull->parent = plofNull;
+        plofGlobal = newPlofObject();
+        plofGlobal->parent = plofGlobal;
+
+        /* And the context */
+        context = newPlofObject();
+        context->parent = plofNull;
+
+    }
 
     /* transfer args */
     plofSetArgs(plofGlobal, (unsigned char *) "args", plofargc, plofargv);
 
-    /* And the context */
-    context = newPlofObject();
-    context->parent = plofNull;
+    /* an image's runtime has its own idea of the args, so let it update */
+    if (imageFile) {
+        struct PlofObject *imageLoad, *imageLoadArg;
+
+        imageLoad = plofRead(plofGlobal, (unsigned char *) "__pul_imageload",
+                             plofHash(15, (unsigned char *) "__pul_imageload"));
+        if (imageLoad != plofNull) {
+            imageLoadArg = newPlofObjectWithArray(0);
+            imageLoadArg->parent = context;
+            plofRet = interpretPSL(imageLoad->parent, imageLoadArg, imageLoad, 0, NULL, 1, 0);
+            if (plofRet.isThrown) {
+                plofThrewUp(plofRet.ret);
+                return 1;
+            }
+        }
+    }
 
     /* load in the files */
     for (fn = 0; fn == 0 || files[fn]; fn++) {
@@ -189,21 +350,12 @@ int main(int argc, char **argv)
             fprintf(stderr, "Compiling %s\n", files[fn]);
         }
 
-        INIT_ATOMIC_BUFFER(file);
-        
         /* find the file */
         if (!strcmp(files[fn], "-")) {
             /* read from stdin */
             fh = stdin;
         } else {
-            fh = fopen(files[fn], "rb");
-        }
-        if (fh == NULL) {
-            for (path = plofIncludePaths; !fh && *path; path++) {
-                char *file = GC_MALLOC_ATOMIC(strlen((char *) *path) + strlen(files[fn]) + 1);
-                sprintf(file, "%s%s", (char *) *path, files[fn]);
-                fh = fopen(file, "rb");
-            }
+            fh = openOnPath(files[fn]);
         }
         if (fh == NULL) {
             perror(files[fn]);
@@ -211,31 +363,49 @@ int main(int argc, char **argv)
         }
 
         /* read it */
-        READ_FILE_BUFFER(file, fh);
-        WRITE_BUFFER(file, "\0", 1);
-        file.bufused--;
+        file.buf = pslLoadFile(fh, &file.bufused);
         fclose(fh);
+        if (fn == 0) stdHash = plofHash(file.bufused, file.buf);
 
         /* check what type of file it is */
+        pslobj = NULL;
         if (isPSLFile(file.bufused, file.buf)) {
             psl = readPSLFile(file.bufused, file.buf);
 
+            /* interpret it in place, so that its data are views of the file */
+            pslobj = newPlofObject();
+            pslobj->parent = plofNull;
+            pslobj->data = (struct PlofData *) newPlofRawDataView(psl.bufused, psl.buf);
+
             /* run immediates */
-            interpretPSL(context, plofNull, NULL, psl.bufused, psl.buf, 0, 1);
+            interpretPSL(context, plofNull, pslobj, 0, NULL, 0, 1);
    
         } else {
-            /* parse it */
-            psl = parseAll(file.buf, (unsigned char *) "top", (unsigned char *) files[fn]);
+            /* parse it (the parser needs it NUL-terminated) */
+            unsigned char *text = (unsigned char *) GC_MALLOC_ATOMIC(file.bufused + 1);
+            memcpy(text, file.buf, file.bufused);
+            text[file.bufused] = '\0';
+            psl = parseAll(text, (unsigned char *) "top", (unsigned char *) files[fn]);
 
         }
 
         /* Now interp */
         if (compileOnly) {
             if (fn > 0) {
+                if (optimize) psl = optimizePSL(psl.buf, psl.bufused);
                 WRITE_BUFFER(compileBuf, psl.buf, psl.bufused);
+            } else if (bundleFile && pslobj) {
+                /* the bundle runs std.psl itself first */
+                struct PlofBundleFile std;
+                std.run = 1;
+                std.name = (unsigned char *) files[0];
+                std.namelen = strlen(files[0]);
+                std.data = file.buf;
+                std.length = file.bufused;
+                WRITE_BUFFER(bundle, &std, 1);
             }
         } else {
-            plofRet = interpretPSL(context, plofNull, NULL, psl.bufused, psl.buf, 0, 0);
+            plofRet = interpretPSL(context, plofNull, pslobj, psl.bufused, psl.buf, 0, 0);
             if (plofRet.isThrown) {
                 plofThrewUp(plofRet.ret);
                 return 1;
@@ -299,7 +469,11 @@ int main(int argc, char **argv)
     }
 
 
-    if (compileOnly) {
+    if (bundleFile) {
+        if (!writeBundle(bundleFile, wdir, &bundle, compileBuf))
+            return 1;
+
+    } else if (compileOnly) {
         FILE *pslf;
 
         /* then write it out */
@@ -312,12 +486,257 @@ int main(int argc, char **argv)
         writePSLFile(pslf, compileBuf.bufused, compileBuf.buf, 0);
     
         fclose(pslf);
+
+    } else if (saveImageFile) {
+        FILE *imgf;
+        struct Buffer_psl grammar = prpGrammarLog();
+        int ok;
+
+        imgf = fopen(saveImageFile, "wb");
+        if (imgf == NULL) {
+            perror(saveImageFile);
+            return 1;
+        }
+
+        ok = plofWriteImage(imgf, context, stdHash, grammar.bufused, grammar.buf);
+        fclose(imgf);
+        if (!ok) {
+            remove(saveImageFile);
+            return 1;
+        }
     }
 
 
     return 0;
 }
 
+/* open a file, looking for it in the include paths if it isn't here */
+FILE *openOnPath(char *name)
+{
+    FILE *fh;
+    unsigned char **path;
+
+    fh = fopen(name, "rb");
+    for (path = plofIncludePaths; !fh && *path; path++) {
+        char *file = GC_MALLOC_ATOMIC(strlen((char *) *path) + strlen(name) + 1);
+        sprintf(file, "%s%s", (char *) *path, name);
+        fh = fopen(file, "rb");
+    }
+    return fh;
+}
+
+/* get PSL as the content of a PSL file */
+static unsigned char *pslFileData(struct Buffer_psl psl, size_t *sz)
+{
+    FILE *tmpf;
+    unsigned char *ret;
+
+    tmpf = tmpfile();
+    if (tmpf == NULL) {
+        perror("tmpfile");
+        return NULL;
+    }
+    writePSLFile(tmpf, psl.bufused, psl.buf, 0);
+    rewind(tmpf);
+    ret = pslLoadFile(tmpf, sz);
+    fclose(tmpf);
+
+    return ret;
+}
+
+/* add a file to a bundle to be included (or run) if it isn't there already,
+ * compiling it if it's Plof, and returning its PSL. Clears *ok if it can't be
+ * bundled */
+static struct Buffer_psl bundleAdd(struct Buffer_BundleFile *bundle, char *name, int run,
+                                   int *ok)
+{
+    struct PlofBundleFile bf;
+    struct Buffer_psl psl;
+    FILE *fh;
+    size_t i;
+
+    psl.buf = NULL;
+    psl.bufused = 0;
+
+    for (i = 0; i < bundle->bufused; i++) {
+        if (bundle->buf[i].namelen == strlen(name) &&
+            !memcmp(bundle->buf[i].name, name, bundle->buf[i].namelen))
+            return psl;
+    }
+
+    fh = openOnPath(name);
+    if (fh == NULL) return psl;
+    bf.data = pslLoadFile(fh, &bf.length);
+    fclose(fh);
+
+    if (isPSLFile(bf.length, bf.data)) {
+        psl = readPSLFile(bf.length, bf.data);
+
+    } else {
+        /* it's loaded with parse, which is just as happy with PSL */
+        unsigned char *text = (unsigned char *) GC_MALLOC_ATOMIC(bf.length + 1);
+        memcpy(text, bf.data, bf.length);
+        text[bf.length] = '\0';
+        psl = parseAll(text, (unsigned char *) "top", (unsigned char *) name);
+
+        /* its immediates just ran, but under cplof they'd run each time it's
+         * included, and the bundle can't parse it again */
+        if (psl.buf && pslHasImmediate(psl.bufused, psl.buf)) {
+            fprintf(stderr, "Can't bundle %s: its immediates must run each time it's "
+                            "included\n", name);
+            *ok = 0;
+            psl.buf = NULL;
+            psl.bufused = 0;
+            return psl;
+        }
+
+        bf.data = pslFileData(psl, &bf.length);
+        if (bf.data == NULL) {
+            psl.buf = NULL;
+            psl.bufused = 0;
+            return psl;
+        }
+
+    }
+
+    fprintf(stderr, "Bundling %s\n", name);
+    bf.run = run;
+    bf.name = (unsigned char *) GC_STRDUP(name);
+    bf.namelen = strlen(name);
+    WRITE_BUFFER(*bundle, &bf, 1);
+
+    return psl;
+}
+
+/* add any file named by a string in this PSL which is on the include path,
+ * as it may be included at runtime. If modules is set, any string may also be
+ * the name of an imported module. Returns 0 if one of them can't be bundled */
+static int bundleScan(struct Buffer_BundleFile *bundle, unsigned char *psl, size_t psllen,
+                      int modules)
+{
+    static const char *suffixes[] = {"", ".psl", ".plof", NULL};
+    size_t psli, len, i;
+    unsigned char cmd;
+    int ok = 1;
+
+    for (psli = 0; psli < psllen; psli++) {
+        cmd = psl[psli];
+        if (cmd < psl_marker) continue;
+
+        psli++;
+        psli += pslBignumToInt(psl + psli, &len);
+
+        if (cmd == psl_raw && len > 0 && len < 256) {
+            char name[256 + 6];
+            int s;
+
+            /* only names that include() accepts */
+            for (i = 0; i < len; i++) {
+                unsigned char c = psl[psli + i];
+                if (!((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') ||
+                      (c >= '0' && c <= '9') || c == '_' || c == '-' || c == '.'))
+                    break;
+            }
+
+            if (i == len) {
+                int named = (len > 4 && !memcmp(psl + psli + len - 4, ".psl", 4)) ||
+                            (len > 5 && !memcmp(psl + psli + len - 5, ".plof", 5));
+
+                for (s = 0; suffixes[s]; s++) {
+                    struct Buffer_psl inc;
+
+                    /* the string itself if it names a file, suffixed if it
+                     * may name a module */
+                    if (s == 0 ? !named : !modules) continue;
+
+                    sprintf(name, "%.*s%s", (int) len, (char *) psl + psli, suffixes[s]);
+                    inc = bundleAdd(bundle, name, 0, &ok);
+                    if (!ok || (inc.buf && !bundleScan(bundle, inc.buf, inc.bufused, modules)))
+                        return 0;
+                }
+            }
+
+        } else if ((cmd == psl_code || cmd == psl_immediate) && isWholePSL(len, psl + psli)) {
+            if (!bundleScan(bundle, psl + psli, len, modules))
+                return 0;
+
+        }
+
+        psli += len - 1;
+    }
+
+    return 1;
+}
+
+/* write out a bundle: psli with std.psl, the program and whatever they may
+ * include appended, returns 0 on failure */
+int writeBundle(char *bundleFile, char *wdir, struct Buffer_BundleFile *bundle,
+                struct Buffer_psl app)
+{
+    struct PlofBundleFile prog;
+    struct Buffer_psl std;
+    unsigned char *runtime;
+    size_t runtimeSz, runs, i;
+    char *runtimeFile;
+    FILE *fh;
+    int ok;
+#ifdef HAVE_UNISTD_H
+    struct stat st;
+#endif
+
+    /* the program */
+    prog.run = 1;
+    prog.name = (unsigned char *) "main.psl";
+    prog.namelen = 8;
+    prog.data = pslFileData(app, &prog.length);
+    if (prog.data == NULL) return 0;
+    WRITE_BUFFER(*bundle, &prog, 1);
+
+    /* and whatever it and std.psl name */
+    runs = bundle->bufused;
+    for (i = 0; i + 1 < runs; i++) {
+        std = readPSLFile(bundle->buf[i].length, bundle->buf[i].data);
+        if (std.buf && !bundleScan(bundle, std.buf, std.bufused, 0)) return 0;
+    }
+    if (!bundleScan(bundle, app.buf, app.bufused, 1)) return 0;
+
+    /* the runtime is psli, next to us */
+    runtimeFile = GC_MALLOC_ATOMIC(strlen(wdir) + 6);
+    sprintf(runtimeFile, "%s/psli", wdir);
+    fh = fopen(runtimeFile, "rb");
+    if (fh == NULL) {
+        perror(runtimeFile);
+        return 0;
+    }
+    runtime = pslLoadFile(fh, &runtimeSz);
+    fclose(fh);
+
+    fh = fopen(bundleFile, "wb");
+    if (fh == NULL) {
+        perror(bundleFile);
+        return 0;
+    }
+    ok = (fwrite(runtime, 1, runtimeSz, fh) == runtimeSz);
+    ok = ok && plofWriteBundle(fh, bundle->bufused, bundle->buf);
+    if (fclose(fh) != 0) ok = 0;
+
+    /* don't leave half an executable behind */
+    if (!ok) {
+        perror(bundleFile);
+#ifdef HAVE_UNISTD_H
+        if (stat(bundleFile, &st) == 0 && S_ISREG(st.st_mode))
+            remove(bundleFile);
+#endif
+        return 0;
+    }
+
+#ifdef HAVE_UNISTD_H
+    chmod(bundleFile, 0755);
+#endif
+
+    return 1;
+}
+
 void usage()
 {
     fprintf(stderr,
@@ -329,13 +748,48 @@ void usage()
             "\tCompile only, don't run.\n"
             "  --output|-o <file>:\n"
             "\tOutput filename (implies -c).\n"
+            "  --optimize|-O:\n"
+            "\tOptimize the compiled PSL.\n"
+            "  --include-path|-I <dir>:\n"
+            "\tLook for included files and modules in dir too.\n");
+
+    fprintf(stderr,
             "  --debug|-g:\n"
             "\tCause the parser to produce debuggable output.\n"
             "  --interactive|-i:\n"
             "\tInteractive (read-execute-loop) mode.\n"
+            "  --image <file>:\n"
+            "\tStart from a heap image instead of loading std.psl.\n"
+            "  --bundle <file>:\n"
+            "\tCompile the files and write a self-contained executable running\n"
+            "\tthem, with std.psl and anything they name on the include path\n"
+            "\tbundled in.\n"
+            "  --save-image <file>:\n"
+            "\tAfter loading std.psl and any other files given, save the heap as\n"
+            "\tan image, for faster startup with --image.\n");
+
+    fprintf(stderr,
             "  --no-intrinsics:\n"
             "\tDo not load intrinsics (much slower execution).\n"
             "  --warn-ambiguous:\n"
             "\tWarn when a parse rule returns more than one result. Not recommended,\n"
-            "\tas ambiguity is often fine.\n");
+            "\tas ambiguity is often fine.\n"
+            "  --profile <file>:\n"
+            "\tSample the running Plof code, and write the samples to file as folded\n"
+            "\tstacks for flamegraph tools at exit. PLOF_PROFILE=<file> does the\n"
+            "\tsame. Code compiled with --debug is named by the line being run.\n");
+
+    fprintf(stderr,
+            "  --stats:\n"
+            "\tWrite the number of garbage collections, the heap size and the peak\n"
+            "\tresident set size to stderr at exit.\n"
+            "  --count-ops:\n"
+            "\tCount the instructions, pairs of instructions and procedure calls\n"
+            "\trun, and write the counts to stderr at exit. PLOF_COUNT_OPS=1 does\n"
+            "\tthe same.\n"
+            "  --parse-profile:\n"
+            "\tProfile the parser, and write a per-production table of calls, memo\n"
+            "\thits, results, bytes consumed and times to stderr at exit.\n"
+            "  --parse-profile-json:\n"
+            "\tAs --parse-profile, but write the profile as JSON.\n");
 }
@@ -22,10 +22,49 @@
  * THE SOFTWARE.
  */
 
+#include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef HAVE_CONFIG_H
+#include "../config.h"
+#else
+#include "basicconfig.h"
+#endif
+
+#ifdef HAVE_STDINT_H
+#include <stdint.h>
+#else
+#include "pstdint.h"
+#endif
+
 #include "plof/memory.h"
+#include "plof/psl.h"
+
+/* the smallest capacity an array grows to */
+#define PLOF_ARRAY_MIN_CAPACITY 8
+
+/* the number of slots in a new map */
+#define PLOF_MAP_MIN_CAPACITY 8
+
+/* concatenations shorter than this are simply copied, rather than making ropes */
+#define PLOF_ROPE_MIN_LENGTH 256
+
+/* slices shorter than this are copied instead of being views */
+#define PLOF_VIEW_MIN_LENGTH 32
+
+/* raw data shorter than this is allocated inline with its header; longer data
+ * is allocated separately, so that the collector needn't scan it. The header
+ * is scanned, so this only saves an allocation for a few words of data. inl
+ * already has room for the terminator */
+#define PLOF_RAW_INLINE_MAX (4 * sizeof(void *))
+#define PLOF_RAW_SIZE(length) (sizeof(struct PlofRawData) + \
+    (((length) < PLOF_RAW_INLINE_MAX) ? (length) : 0))
+
+#define BUFFER_GC
+#include "plof/buffer.h"
+BUFFER(RawData, struct PlofRawData *);
 
 static struct PlofObject *plofObjectFreeList = NULL;
 
@@ -51,26 +90,150 @@ void freePlofObject(struct PlofObject *tofree)
     plofObjectFreeList = tofree;
 }
 
+/* Set up a PlofRawData allocated with PLOF_RAW_SIZE(length) bytes */
+static void initPlofRawData(struct PlofRawData *rd, size_t length)
+{
+    rd->type = PLOF_DATA_RAW;
+    rd->length = length;
+    if (length < PLOF_RAW_INLINE_MAX) {
+        /* already zeroed by GC_MALLOC */
+        rd->data = rd->inl;
+    } else {
+        rd->data = GC_MALLOC_ATOMIC(length + 1);
+        memset(rd->data, 0, length + 1);
+    }
+}
+
 /* Allocate a PlofRawData */
 struct PlofRawData *newPlofRawData(size_t length)
 {
     struct PlofRawData *rd;
+    rd = (struct PlofRawData *) GC_MALLOC(PLOF_RAW_SIZE(length));
+    initPlofRawData(rd, length);
+    return rd;
+}
+
+/* Allocate a PlofRawData with non-atomic data */
+struct PlofRawData *newPlofRawDataNonAtomic(size_t length)
+{
+    struct PlofRawData *rd;
+    rd = (struct PlofRawData *) GC_MALLOC(sizeof(struct PlofRawData) + length);
+    rd->type = PLOF_DATA_RAW;
+    rd->length = length;
+    rd->data = rd->inl;
+    return rd;
+}
+
+/* Concatenate two PlofRawDatas. Long results are ropes, so that repeated
+ * concatenation is linear */
+struct PlofRawData *plofRawConcat(struct PlofRawData *left, struct PlofRawData *right)
+{
+    struct PlofRawData *rd;
+    size_t length = left->length + right->length;
+
+    /* short ones can just be copied (and can't be made of ropes) */
+    if (length < PLOF_ROPE_MIN_LENGTH) {
+        rd = newPlofRawData(length);
+        memcpy(rd->data, left->data, left->length);
+        memcpy(rd->data + left->length, right->data, right->length);
+        return rd;
+    }
+
     rd = GC_NEW(struct PlofRawData);
     rd->type = PLOF_DATA_RAW;
     rd->length = length;
-    rd->data = GC_MALLOC_ATOMIC(length + 1);
-    memset(rd->data, 0, length + 1);
+    rd->left = left;
+    rd->right = right;
     return rd;
 }
 
-/* Allocate a PlofRawData with non-atomic data */
-struct PlofRawData *newPlofRawDataNonAtomic(size_t length)
+/* Flatten a rope PlofRawData in place, so that its data is available */
+struct PlofRawData *plofRawFlatten(struct PlofRawData *rd)
+{
+    struct Buffer_RawData stack;
+    struct PlofRawData *cur;
+    unsigned char *data, *into;
+
+    if (rd->data) return rd;
+
+    data = into = GC_MALLOC_ATOMIC(rd->length + 1);
+
+    /* ropes built by repeated concatenation are very deep, so walk this one
+     * with an explicit stack instead of recursing */
+    INIT_BUFFER(stack);
+    WRITE_BUFFER(stack, &rd, 1);
+    while (stack.bufused) {
+        cur = stack.buf[--stack.bufused];
+
+        if (cur->data) {
+            memcpy(into, cur->data, cur->length);
+            into += cur->length;
+
+        } else {
+            WRITE_BUFFER(stack, &cur->right, 1);
+            WRITE_BUFFER(stack, &cur->left, 1);
+
+        }
+    }
+    *into = '\0';
+
+    /* now it's just data */
+    rd->data = data;
+    rd->left = rd->right = NULL;
+
+    return rd;
+}
+
+/* Get a slice of a (flat) PlofRawData. Long slices are views of of's buffer
+ * rather than copies */
+struct PlofRawData *plofRawSlice(struct PlofRawData *of, size_t start, size_t length)
 {
     struct PlofRawData *rd;
+
+    /* short ones are cheaper to copy, and are then usable as C strings */
+    if (length < PLOF_VIEW_MIN_LENGTH) {
+        rd = newPlofRawData(length);
+        memcpy(rd->data, of->data + start, length);
+        return rd;
+    }
+
     rd = GC_NEW(struct PlofRawData);
     rd->type = PLOF_DATA_RAW;
     rd->length = length;
-    rd->data = GC_MALLOC(length);
+    rd->data = of->data + start;
+
+    /* views of views share the original buffer */
+    rd->base = of->base ? of->base : of;
+    return rd;
+}
+
+/* Make a PlofRawData of data which mustn't be written to (such as a loaded
+ * file). It's a view of itself, so it's copied if it needs to be */
+struct PlofRawData *newPlofRawDataView(size_t length, unsigned char *data)
+{
+    struct PlofRawData *rd = GC_NEW(struct PlofRawData);
+    rd->type = PLOF_DATA_RAW;
+    rd->length = length;
+    rd->data = data;
+    rd->base = rd;
+    return rd;
+}
+
+/* Give a view its own NUL-terminated copy of its data, so that it can be
+ * written to or used as a C string */
+struct PlofRawData *plofRawUnshare(struct PlofRawData *rd)
+{
+    unsigned char *data;
+
+    if (!rd->base) return rd;
+
+    data = GC_MALLOC_ATOMIC(rd->length + 1);
+    memcpy(data, rd->data, rd->length);
+    data[rd->length] = '\0';
+
+    rd->data = data;
+    rd->base = NULL;
+
     return rd;
 }
 
@@ -81,7 +244,7 @@ struct PlofArrayData *newPlofArrayData(size_t length)
     ad = (struct PlofArrayData *) GC_MALLOC(sizeof(struct PlofArrayData) +
                                             length * sizeof(struct PlofObject *));
     ad->type = PLOF_DATA_ARRAY;
-    ad->length = length;
+    ad->length = ad->capacity = length;
     ad->data = (struct PlofObject **) (ad + 1);
     return ad;
 }
@@ -98,6 +261,18 @@ struct PlofArrayData *newPlofLocalsData(size_t length)
     return ad;
 }
 
+/* Allocate an empty PlofMapData */
+struct PlofMapData *newPlofMapData()
+{
+    struct PlofMapData *md;
+    md = GC_NEW(struct PlofMapData);
+    md->type = PLOF_DATA_MAP;
+    md->length = 0;
+    md->capacity = PLOF_MAP_MIN_CAPACITY;
+    md->slots = (struct PlofMapSlot *) GC_MALLOC(md->capacity * sizeof(struct PlofMapSlot));
+    return md;
+}
+
 /* Allocate an objects with raw data inline */
 struct PlofObject *newPlofObjectWithRaw(size_t length)
 {
@@ -105,8 +280,11 @@ struct PlofObject *newPlofObjectWithRaw(size_t length)
     struct PlofRawData *rd;
 
     /* allocate them */
-    obj = newPlofObject();
-    rd = newPlofRawData(length);
+    obj = (struct PlofObject *) GC_MALLOC(sizeof(struct PlofObject) + PLOF_RAW_SIZE(length));
+    rd = (struct PlofRawData *) (obj + 1);
+    initPlofRawData(rd, length);
+
+    /* set up the object */
     obj->data = (struct PlofData *) rd;
 
     return obj;
@@ -131,11 +309,210 @@ struct PlofObject *newPlofObjectWithArray(size_t length)
 
     /* set up the array */
     ad->type = PLOF_DATA_ARRAY;
-    ad->length = length;
+    ad->length = ad->capacity = length;
     ad->data = (struct PlofObject **) (ad + 1);
 
     return obj;
 }
 
+/* Set the length of an array, growing its capacity geometrically if needed.
+ * New elements are null */
+void plofArrayResize(struct PlofArrayData *ad, size_t length)
+{
+    size_t i;
+
+    if (length > ad->capacity) {
+        /* the data may be inline, so it can't be realloc'd */
+        struct PlofObject **data;
+        size_t capacity = ad->capacity * 2;
+        if (capacity < length) capacity = length;
+        if (capacity < PLOF_ARRAY_MIN_CAPACITY) capacity = PLOF_ARRAY_MIN_CAPACITY;
+
+        data = (struct PlofObject **) GC_MALLOC(capacity * sizeof(struct PlofObject *));
+        memcpy(data, ad->data, ad->length * sizeof(struct PlofObject *));
+        ad->data = data;
+        ad->capacity = capacity;
+    }
+
+    /* null out anything new, and forget anything dropped */
+    for (i = ad->length; i < length; i++)
+        ad->data[i] = plofNull;
+    for (i = length; i < ad->length; i++)
+        ad->data[i] = NULL;
+
+    ad->length = length;
+}
+
+/* Append the elements of one array to another (which may be the same array) */
+void plofArrayAppend(struct PlofArrayData *ad, struct PlofArrayData *from)
+{
+    size_t oldlen = ad->length, fromlen = from->length;
+
+    plofArrayResize(ad, oldlen + fromlen);
+
+    /* if from is ad, its original elements are still at the start */
+    memcpy(ad->data + oldlen, from->data, fromlen * sizeof(struct PlofObject *));
+}
+
+/* Expand op(T) once for each supported typed array kind, with T the C type of
+ * the elements, so that every loop is over a concrete type */
+#define TYPED_KINDS(kind, op) \
+    switch (kind) { \
+        case psl_ctype_uint8: op(uint8_t); break; \
+        case psl_ctype_int32: op(int32_t); break; \
+        case psl_ctype_int64: op(int64_t); break; \
+    }
+
+/* Allocate a zeroed PlofTypedData of the given psl_ctype, or NULL if that kind
+ * isn't supported */
+struct PlofTypedData *newPlofTypedData(int kind, size_t length)
+{
+    struct PlofTypedData *td;
+    size_t width;
+
+    switch (kind) {
+        case psl_ctype_uint8: width = 1; break;
+        case psl_ctype_int32: width = 4; break;
+        case psl_ctype_int64: width = 8; break;
+        default: return NULL;
+    }
+
+    /* there are no pointers in here, so the collector needn't scan it */
+    td = (struct PlofTypedData *) GC_MALLOC_ATOMIC(sizeof(struct PlofTypedData) + width * length);
+    memset(td->data, 0, width * length);
+    td->type = PLOF_DATA_TYPED;
+    td->kind = kind;
+    td->width = width;
+    td->length = length;
+    return td;
+}
+
+/* Get an element of a typed array */
+ptrdiff_t plofTypedGet(struct PlofTypedData *td, size_t index)
+{
+#define GET(T) return (ptrdiff_t) ((T *) td->data)[index]
+    TYPED_KINDS(td->kind, GET);
+#undef GET
+    return 0;
+}
+
+/* Set an element of a typed array */
+void plofTypedSet(struct PlofTypedData *td, size_t index, ptrdiff_t val)
+{
+#define SET(T) ((T *) td->data)[index] = (T) val
+    TYPED_KINDS(td->kind, SET);
+#undef SET
+}
+
+/* Set elements [start, end) of a typed array to val */
+void plofTypedFill(struct PlofTypedData *td, ptrdiff_t val, size_t start, size_t end)
+{
+    size_t i;
+#define FILL(T) \
+    { \
+        T *data = (T *) td->data, tval = (T) val; \
+        for (i = start; i < end; i++) data[i] = tval; \
+    }
+    TYPED_KINDS(td->kind, FILL);
+#undef FILL
+}
+
+/* Copy count elements from src at soff into dst at doff */
+void plofTypedCopy(struct PlofTypedData *dst, size_t doff,
+                   struct PlofTypedData *src, size_t soff, size_t count)
+{
+    size_t i;
+
+    if (dst->kind == src->kind) {
+        memmove(dst->data + doff * dst->width, src->data + soff * src->width, count * dst->width);
+        return;
+    }
+
+    /* converting, so go element by element, backwards if that's needed to
+     * survive overlap */
+    if (dst == src && doff > soff) {
+        for (i = count; i > 0; i--)
+            plofTypedSet(dst, doff + i - 1, plofTypedGet(src, soff + i - 1));
+    } else {
+        for (i = 0; i < count; i++)
+            plofTypedSet(dst, doff + i, plofTypedGet(src, soff + i));
+    }
+}
+
+/* Apply an integer operation elementwise */
+int plofTypedArith(struct PlofTypedData *dst, struct PlofTypedData *src, ptrdiff_t val, int op)
+{
+    size_t i, length = dst->length;
+
+    /* mixed kinds go through a temporary of dst's kind */
+    if (src && src->kind != dst->kind) {
+        struct PlofTypedData *tmp;
+        if (src->length < length) length = src->length;
+        tmp = newPlofTypedData(dst->kind, length);
+        plofTypedCopy(tmp, 0, src, 0, length);
+        src = tmp;
+    }
+    if (src && src->length < length) length = src->length;
+
+#define ARITH_LOOP(T, oper) \
+    { \
+        T *data = (T *) dst->data; \
+        if (src) { \
+            T *sdata = (T *) src->data; \
+            for (i = 0; i < length; i++) data[i] = data[i] oper sdata[i]; \
+        } else { \
+            T tval = (T) val; \
+            for (i = 0; i < length; i++) data[i] = data[i] oper tval; \
+        } \
+    }
+#define ARITH(T) \
+    switch (op) { \
+        case psl_add: ARITH_LOOP(T, +); break; \
+        case psl_sub: ARITH_LOOP(T, -); break; \
+        case psl_mul: ARITH_LOOP(T, *); break; \
+        case psl_and: ARITH_LOOP(T, &); break; \
+        case psl_or:  ARITH_LOOP(T, |); break; \
+        case psl_xor: ARITH_LOOP(T, ^); break; \
+        default: return 0; \
+    }
+    TYPED_KINDS(dst->kind, ARITH);
+#undef ARITH
+#undef ARITH_LOOP
+
+    return 1;
+}
+
+/* Reduce a typed array with an integer operation */
+int plofTypedReduce(struct PlofTypedData *td, int op, ptrdiff_t *into)
+{
+    size_t i, length = td->length;
+
+#define REDUCE_LOOP(T, init, step) \
+    { \
+        T *data = (T *) td->data; \
+        ptrdiff_t res = (init); \
+        for (i = 0; i < length; i++) step; \
+        *into = res; \
+    }
+#define REDUCE(T) \
+    switch (op) { \
+        case psl_add: REDUCE_LOOP(T, 0, res += data[i]); break; \
+        case psl_mul: REDUCE_LOOP(T, 1, res *= data[i]); break; \
+        case psl_and: REDUCE_LOOP(T, -1, res &= data[i]); break; \
+        case psl_or:  REDUCE_LOOP(T, 0, res |= data[i]); break; \
+        case psl_xor: REDUCE_LOOP(T, 0, res ^= data[i]); break; \
+        case psl_lt: \
+            REDUCE_LOOP(T, length ? data[0] : 0, if (data[i] < res) res = data[i]); break; \
+        case psl_gt: \
+            REDUCE_LOOP(T, length ? data[0] : 0, if (data[i] > res) res = data[i]); break; \
+        default: return 0; \
+    }
+    TYPED_KINDS(td->kind, REDUCE);
+#undef REDUCE
+#undef REDUCE_LOOP
+
+    return 1;
+}
+
 /* Free a PlofData (either kind) */
 void freePlofData(struct PlofData *obj) {}
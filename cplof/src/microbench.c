@@ -0,0 +1,479 @@
+/*
+ * Microbenchmarks for the runtime's primitives
+ *
+ * Copyright (C) 2010 Gregor Richards
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "plof/bignum.h"
+#include "plof/memory.h"
+#include "plof/packrat.h"
+#include "plof/plof.h"
+#include "plof/psl.h"
+#include "interp.h"
+
+/* Each benchmark is calibrated to take at least benchMinTime per run, then
+ * run once untimed, then benchReps times timed. The median time per
+ * operation is reported, along with the fastest and slowest runs */
+static double benchMinTime = 20000000;
+static int benchReps = 7;
+
+/* results are written here, so that the work can't be optimized away */
+static volatile size_t benchSink;
+static void *volatile benchSinkP;
+
+/* a benchmark. setup is run once before timing, run does iters operations */
+struct Bench {
+    const char *name;
+    size_t arg;
+    void (*setup)(size_t arg);
+    void (*run)(size_t iters, size_t arg);
+};
+
+/* member names to read and write, with their hashes */
+#define BENCH_NAMES 256
+static unsigned char *benchNames[BENCH_NAMES];
+static size_t benchHashes[BENCH_NAMES];
+static unsigned char *benchMissName = (unsigned char *) "notamember";
+static size_t benchMissHash;
+
+/* shared state for the current benchmark */
+static struct PlofObject *benchObj, *benchObj2, *benchContext;
+static struct PlofObject *benchProc;
+static unsigned char *benchBuf;
+static size_t benchBufLen;
+static struct Production *benchProd;
+
+
+/* the cost of the loop itself */
+static void runOverhead(size_t iters, size_t arg)
+{
+    size_t i;
+    for (i = 0; i < iters; i++)
+        benchSink = i;
+}
+
+
+/* an object with arg members (a power of two) */
+static void setupMembers(size_t arg)
+{
+    size_t i;
+    benchObj = newPlofObject();
+    benchObj->parent = plofNull;
+    for (i = 0; i < arg; i++)
+        plofWrite(benchObj, benchNames[i], benchHashes[i], plofNull);
+}
+
+static void runReadHit(size_t iters, size_t arg)
+{
+    size_t i;
+    for (i = 0; i < iters; i++) {
+        size_t n = i & (arg - 1);
+        benchSinkP = plofRead(benchObj, benchNames[n], benchHashes[n]);
+    }
+}
+
+static void runReadMiss(size_t iters, size_t arg)
+{
+    size_t i;
+    for (i = 0; i < iters; i++)
+        benchSinkP = plofRead(benchObj, benchMissName, benchMissHash);
+}
+
+static void runWriteHit(size_t iters, size_t arg)
+{
+    size_t i;
+    for (i = 0; i < iters; i++) {
+        size_t n = i & (arg - 1);
+        plofWrite(benchObj, benchNames[n], benchHashes[n], benchObj);
+    }
+}
+
+/* writing a new member, into a fresh object (so this includes allocating it) */
+static void runWriteMiss(size_t iters, size_t arg)
+{
+    size_t i;
+    for (i = 0; i < iters; i++) {
+        struct PlofObject *obj = newPlofObject();
+        plofWrite(obj, benchMissName, benchMissHash, plofNull);
+        benchSinkP = obj;
+    }
+}
+
+
+/* a string of arg bytes to hash */
+static void setupHash(size_t arg)
+{
+    size_t i;
+    benchBuf = GC_MALLOC_ATOMIC(arg);
+    for (i = 0; i < arg; i++)
+        benchBuf[i] = 'a' + (i % 26);
+}
+
+static void runHash(size_t iters, size_t arg)
+{
+    size_t i;
+    for (i = 0; i < iters; i++) {
+        benchBuf[0] = i;
+        benchSink = plofHash(arg, benchBuf);
+    }
+}
+
+
+static void runNewObject(size_t iters, size_t arg)
+{
+    size_t i;
+    for (i = 0; i < iters; i++)
+        benchSinkP = newPlofObject();
+}
+
+static void runNewObjectWithRaw(size_t iters, size_t arg)
+{
+    size_t i;
+    for (i = 0; i < iters; i++)
+        benchSinkP = newPlofObjectWithRaw(arg);
+}
+
+static void runNewObjectWithArray(size_t iters, size_t arg)
+{
+    size_t i;
+    for (i = 0; i < iters; i++)
+        benchSinkP = newPlofObjectWithArray(arg);
+}
+
+
+/* write a raw instruction */
+static size_t writeRaw(unsigned char *into, size_t len, const char *data)
+{
+    size_t blen = pslBignumLength(len);
+    into[0] = psl_raw;
+    pslIntToBignum(into + 1, len, blen);
+    memcpy(into + 1 + blen, data, len);
+    return 1 + blen + len;
+}
+
+/* arg repetitions of "global "m" member pop", a common shape of PSL */
+static void setupCompile(size_t arg)
+{
+    size_t i;
+    benchBuf = GC_MALLOC_ATOMIC(arg * 8);
+    benchBufLen = 0;
+    for (i = 0; i < arg; i++) {
+        benchBuf[benchBufLen++] = psl_global;
+        benchBufLen += writeRaw(benchBuf + benchBufLen, 1, "m");
+        benchBuf[benchBufLen++] = psl_member;
+        benchBuf[benchBufLen++] = psl_pop;
+    }
+}
+
+static void runCompile(size_t iters, size_t arg)
+{
+    size_t i, cpsllen;
+    void **cpslargs;
+    for (i = 0; i < iters; i++) {
+        compilePSL(benchBufLen, benchBuf, NULL, 0, NULL, NULL, NULL, &cpsllen, &cpslargs);
+        benchSinkP = cpslargs;
+    }
+}
+
+
+/* a procedure with arg repetitions of "this pop" (so, none is empty) */
+static void setupInterpret(size_t arg)
+{
+    size_t i;
+    struct PlofRawData *rd;
+    benchProc = newPlofObjectWithRaw(arg * 2);
+    benchProc->parent = plofNull;
+    rd = (struct PlofRawData *) benchProc->data;
+    for (i = 0; i < arg; i++) {
+        rd->data[i*2] = psl_this;
+        rd->data[i*2+1] = psl_pop;
+    }
+}
+
+static void runInterpret(size_t iters, size_t arg)
+{
+    size_t i;
+    struct PlofReturn ret;
+    for (i = 0; i < iters; i++) {
+        ret = interpretPSL(benchContext, plofNull, benchProc, 0, NULL, 1, 0);
+        benchSinkP = ret.ret;
+    }
+}
+
+
+/* a value as a bignum */
+static void setupBignum(size_t arg)
+{
+    benchBufLen = pslBignumLength(arg);
+    benchBuf = GC_MALLOC_ATOMIC(benchBufLen);
+    pslIntToBignum(benchBuf, arg, benchBufLen);
+}
+
+static void runBignumToInt(size_t iters, size_t arg)
+{
+    size_t i, val;
+    for (i = 0; i < iters; i++) {
+        benchSink = pslBignumToInt(benchBuf, &val);
+        benchSink = val;
+    }
+}
+
+static void runIntToBignum(size_t iters, size_t arg)
+{
+    size_t i;
+    for (i = 0; i < iters; i++) {
+        pslIntToBignum(benchBuf, arg, pslBignumLength(arg));
+        benchSink = benchBuf[0];
+    }
+}
+
+
+/* two objects of arg members each, with no names in common */
+static void setupCombine(size_t arg)
+{
+    size_t i;
+    benchObj = newPlofObject();
+    benchObj->parent = plofNull;
+    benchObj2 = newPlofObject();
+    benchObj2->parent = plofNull;
+    for (i = 0; i < arg; i++) {
+        plofWrite(benchObj, benchNames[i*2], benchHashes[i*2], plofNull);
+        plofWrite(benchObj2, benchNames[i*2+1], benchHashes[i*2+1], plofNull);
+    }
+}
+
+static void runCombine(size_t iters, size_t arg)
+{
+    size_t i;
+    for (i = 0; i < iters; i++)
+        benchSinkP = plofCombine(benchObj, benchObj2);
+}
+
+
+/* make a nonterminal with two alternatives */
+static void benchNonterminal(const char *name, const char **left, const char **right)
+{
+    unsigned char ***sub = GC_MALLOC(3 * sizeof(unsigned char **));
+    sub[0] = (unsigned char **) left;
+    sub[1] = (unsigned char **) right;
+    sub[2] = NULL;
+    newPackratNonterminal((unsigned char *) name, sub);
+}
+
+/* a left-recursive sum of arg numbers: sum := sum "+" num | num */
+static void setupParseSum(size_t arg)
+{
+    static const char *left[] = {"bench_sum", "bench_plus", "bench_num", NULL};
+    static const char *right[] = {"bench_num", NULL};
+    size_t i;
+
+    newPackratRegexTerminal((unsigned char *) "bench_num", (unsigned char *) "[0-9]+");
+    newPackratRegexTerminal((unsigned char *) "bench_plus", (unsigned char *) "\\+");
+    benchNonterminal("bench_sum", left, right);
+    benchProd = getProduction((unsigned char *) "bench_sum");
+
+    benchBuf = GC_MALLOC_ATOMIC(arg * 4 + 1);
+    benchBufLen = 0;
+    for (i = 0; i < arg; i++)
+        benchBufLen += sprintf((char *) benchBuf + benchBufLen, i ? "+%d" : "%d", (int) (i % 100));
+}
+
+/* arg nested parentheses: parens := "(" parens ")" | "(" ")" */
+static void setupParseParens(size_t arg)
+{
+    static const char *left[] = {"bench_open", "bench_parens", "bench_close", NULL};
+    static const char *right[] = {"bench_open", "bench_close", NULL};
+    size_t i;
+
+    newPackratRegexTerminal((unsigned char *) "bench_open", (unsigned char *) "\\(");
+    newPackratRegexTerminal((unsigned char *) "bench_close", (unsigned char *) "\\)");
+    benchNonterminal("bench_parens", left, right);
+    benchProd = getProduction((unsigned char *) "bench_parens");
+
+    benchBuf = GC_MALLOC_ATOMIC(arg * 2 + 1);
+    for (i = 0; i < arg; i++) {
+        benchBuf[i] = '(';
+        benchBuf[arg*2-i-1] = ')';
+    }
+    benchBuf[arg*2] = '\0';
+}
+
+static void runParse(size_t iters, size_t arg)
+{
+    size_t i;
+    struct ParseContext ctx;
+    struct ParseResult *res;
+    for (i = 0; i < iters; i++) {
+        memset(&ctx, 0, sizeof(struct ParseContext));
+        res = packratParse(&ctx, benchProd, (unsigned char *) "bench", 1, 0, benchBuf);
+        if (res == NULL || res->consumedTo != strlen((char *) benchBuf)) {
+            fprintf(stderr, "Benchmark grammar failed to parse!\n");
+            exit(1);
+        }
+        benchSinkP = res;
+    }
+}
+
+
+static struct Bench benches[] = {
+    {"overhead",                    0,   NULL,            runOverhead},
+    {"plofRead-hit",                1,   setupMembers,    runReadHit},
+    {"plofRead-hit",                16,  setupMembers,    runReadHit},
+    {"plofRead-hit",                256, setupMembers,    runReadHit},
+    {"plofRead-miss",               1,   setupMembers,    runReadMiss},
+    {"plofRead-miss",               16,  setupMembers,    runReadMiss},
+    {"plofRead-miss",               256, setupMembers,    runReadMiss},
+    {"plofWrite-hit",               1,   setupMembers,    runWriteHit},
+    {"plofWrite-hit",               16,  setupMembers,    runWriteHit},
+    {"plofWrite-hit",               256, setupMembers,    runWriteHit},
+    {"plofWrite-miss",              0,   NULL,            runWriteMiss},
+    {"plofHash",                    8,   setupHash,       runHash},
+    {"plofHash",                    64,  setupHash,       runHash},
+    {"newPlofObject",               0,   NULL,            runNewObject},
+    {"newPlofObjectWithRaw",        16,  NULL,            runNewObjectWithRaw},
+    {"newPlofObjectWithArray",      4,   NULL,            runNewObjectWithArray},
+    {"compilePSL",                  8,   setupCompile,    runCompile},
+    {"compilePSL",                  64,  setupCompile,    runCompile},
+    {"interpretPSL",                0,   setupInterpret,  runInterpret},
+    {"interpretPSL",                1,   setupInterpret,  runInterpret},
+    {"pslBignumToInt",              100, setupBignum,     runBignumToInt},
+    {"pslBignumToInt",              1000000000, setupBignum, runBignumToInt},
+    {"pslIntToBignum",              100, setupBignum,     runIntToBignum},
+    {"pslIntToBignum",              1000000000, setupBignum, runIntToBignum},
+    {"plofCombine",                 4,   setupCombine,    runCombine},
+    {"plofCombine",                 64,  setupCombine,    runCombine},
+    {"packratParse-sum",            10,  setupParseSum,   runParse},
+    {"packratParse-sum",            100, setupParseSum,   runParse},
+    {"packratParse-parens",         10,  setupParseParens, runParse},
+    {"packratParse-parens",         100, setupParseParens, runParse},
+    {NULL, 0, NULL, NULL}
+};
+
+static int benchCmp(const void *l, const void *r)
+{
+    double ld = *((double *) l), rd = *((double *) r);
+    if (ld < rd) return -1;
+    if (ld > rd) return 1;
+    return 0;
+}
+
+/* run a benchmark and report on it */
+static void runBench(struct Bench *bench)
+{
+    size_t iters;
+    double start, elapsed;
+    double *times;
+    char name[64];
+    int i;
+
+    if (bench->setup) bench->setup(bench->arg);
+
+    /* find how many iterations make a long enough run */
+    for (iters = 1;; iters *= 2) {
+        start = packratProfileClock();
+        bench->run(iters, bench->arg);
+        elapsed = packratProfileClock() - start;
+        if (elapsed >= benchMinTime) break;
+        if (elapsed < benchMinTime / 16) iters *= 4;
+    }
+
+    /* warm up */
+    bench->run(iters, bench->arg);
+
+    /* then time it */
+    times = malloc(benchReps * sizeof(double));
+    for (i = 0; i < benchReps; i++) {
+        start = packratProfileClock();
+        bench->run(iters, bench->arg);
+        elapsed = packratProfileClock() - start;
+        times[i] = elapsed / iters;
+    }
+    qsort(times, benchReps, sizeof(double), benchCmp);
+
+    sprintf(name, "%.40s/%lu", bench->name, (unsigned long) bench->arg);
+    printf("%-32s %12.2f %12.2f %12.2f %12lu\n", name,
+           (benchReps % 2) ? times[benchReps/2] : (times[benchReps/2-1] + times[benchReps/2]) / 2,
+           times[0], times[benchReps-1], (unsigned long) iters);
+    fflush(stdout);
+
+    free(times);
+}
+
+int main(int argc, char **argv)
+{
+    struct PlofReturn ret;
+    int argn, i, j, ran;
+    char name[16];
+
+    GC_INIT();
+
+    for (argn = 1; argn < argc && argv[argn][0] == '-'; argn++) {
+        if (!strcmp(argv[argn], "-t") && argn + 1 < argc) {
+            benchMinTime = atol(argv[++argn]) * 1000000.0;
+        } else if (!strcmp(argv[argn], "-r") && argn + 1 < argc) {
+            benchReps = atoi(argv[++argn]);
+        } else {
+            break;
+        }
+    }
+    if ((argn < argc && argv[argn][0] == '-') || benchReps < 1) {
+        fprintf(stderr, "Use: microbench [-t <ms per run>] [-r <runs>] [benchmark name]...\n");
+        return 1;
+    }
+
+    /* Initialize null and global */
+    plofNull = newPlofObject();
+    plofNull->parent = plofNull;
+    plofGlobal = newPlofObject();
+    plofGlobal->parent = plofGlobal;
+    benchContext = newPlofObject();
+    benchContext->parent = plofNull;
+
+    for (i = 0; i < BENCH_NAMES; i++) {
+        sprintf(name, "m%d", i);
+        benchNames[i] = (unsigned char *) GC_STRDUP(name);
+        benchHashes[i] = plofHash(strlen(name), benchNames[i]);
+    }
+    benchMissHash = plofHash(strlen((char *) benchMissName), benchMissName);
+
+    /* compilePSL needs the interpreter to have been set up */
+    setupInterpret(1);
+    ret = interpretPSL(benchContext, plofNull, benchProc, 0, NULL, 1, 0);
+    if (ret.isThrown) {
+        fprintf(stderr, "Failed to set up the interpreter!\n");
+        return 1;
+    }
+
+    printf("%-32s %12s %12s %12s %12s\n", "benchmark/arg", "median(ns)", "min", "max", "iterations");
+    for (i = 0; benches[i].name; i++) {
+        /* only run the named benchmarks, if any are named */
+        ran = (argn >= argc);
+        for (j = argn; j < argc; j++)
+            if (!strcmp(argv[j], benches[i].name)) ran = 1;
+        if (ran) runBench(&benches[i]);
+    }
+
+    return 0;
+}
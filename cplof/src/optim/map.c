@@ -0,0 +1,2 @@
+ARITY(0)
+PUSHES(1)
@@ -0,0 +1,2 @@
+ARITY(2)
+LEAKA
@@ -0,0 +1,3 @@
+ARITY(2)
+PUSHES(1)
+LEAKP
@@ -0,0 +1,4 @@
+ARITY(3)
+LEAKA
+LEAKB
+LEAKC
@@ -0,0 +1,2 @@
+ARITY(3)
+LEAKA
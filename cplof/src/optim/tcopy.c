@@ -0,0 +1,2 @@
+ARITY(5)
+LEAKA
@@ -0,0 +1,2 @@
+ARITY(4)
+LEAKA
@@ -0,0 +1,2 @@
+ARITY(2)
+PUSHES(1)
@@ -0,0 +1,2 @@
+ARITY(1)
+PUSHES(1)
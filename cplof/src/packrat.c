@@ -24,7 +24,9 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #include <gc/gc.h>
 #include <pcre.h>
@@ -38,16 +40,93 @@ BUFFER(ParseResult, struct ParseResult *);
 BUFFER(Production, struct Production *);
 BUFFER(Production_p, struct Production **);
 
-struct Production *productions = NULL;
+/* all productions, indexed by ID */
+struct Production **productions = NULL;
+size_t productionCount = 0;
+static size_t productionsSize = 0;
+
+/* the hash table of productions by name */
+#define PRODUCTION_TABLE_DEFAULT_SIZE 256
+static struct Production **productionTable = NULL;
+static size_t productionTableSize = 0;
+
+/* the memoization caches, indexed by production ID and then by offset. These
+ * are only meaningful during a single parse */
+static struct ParseResult ****parseCaches = NULL;
+static size_t *parseCacheSizes = NULL;
+static size_t parseCachesSize = 0;
 
 int packratWarnAmbiguous = 0;
 
-/* create a new, empty production with the given name */
-static struct Production *newProduction(const unsigned char *name)
+/* profiling data, kept by name in a simple hash table */
+#define PROFILE_TABLE_SIZE 256
+int packratProfile = 0;
+static struct PackratProfile *profileTable[PROFILE_TABLE_SIZE];
+static size_t profileCount = 0;
+
+/* time spent in subproductions of the production currently being profiled */
+static double profileChildTime = 0;
+
+/* hash a production name (the same sdbm hash used for Plof names) */
+static size_t productionHash(const unsigned char *name)
+{
+    size_t hash = 0;
+
+    for (; *name; name++)
+        hash = (*name) + (hash << 6) + (hash << 16) - hash;
+
+    return hash;
+}
+
+/* double the size of the production hash table, rehashing everything in it */
+static void growProductionTable()
+{
+    struct Production **oldTable = productionTable;
+    size_t oldSize = productionTableSize, i;
+
+    if (productionTableSize == 0) {
+        productionTableSize = PRODUCTION_TABLE_DEFAULT_SIZE;
+    } else {
+        productionTableSize *= 2;
+    }
+    productionTable = GC_MALLOC(productionTableSize * sizeof(struct Production *));
+
+    for (i = 0; i < oldSize; i++) {
+        struct Production *curp = oldTable[i], *nextp;
+        while (curp) {
+            size_t bucket = curp->hash & (productionTableSize - 1);
+            nextp = curp->next;
+            curp->next = productionTable[bucket];
+            productionTable[bucket] = curp;
+            curp = nextp;
+        }
+    }
+}
+
+/* create a new, empty production with the given name and hash, giving it the
+ * next ID */
+static struct Production *newProduction(const unsigned char *name, size_t hash)
 {
     struct Production *ret = GC_NEW(struct Production);
+    size_t bucket;
 
     ret->name = (unsigned char *) GC_STRDUP((char *) name);
+    ret->hash = hash;
+
+    /* give it an ID */
+    if (productionCount >= productionsSize) {
+        productionsSize = productionsSize ? productionsSize * 2 : PRODUCTION_TABLE_DEFAULT_SIZE;
+        productions = GC_REALLOC(productions, productionsSize * sizeof(struct Production *));
+    }
+    ret->id = productionCount;
+    productions[productionCount++] = ret;
+
+    /* and put it in the table, keeping the load factor below 1 */
+    if (productionCount > productionTableSize)
+        growProductionTable();
+    bucket = hash & (productionTableSize - 1);
+    ret->next = productionTable[bucket];
+    productionTable[bucket] = ret;
 
     return ret;
 }
@@ -56,35 +135,17 @@ static struct Production *newProduction(const unsigned char *name)
  * may have NULL functionality */
 struct Production *getProduction(const unsigned char *name)
 {
-    struct Production *curp = productions;
-
-    /* first production */
-    if (curp == NULL) {
-        return (productions = newProduction(name));
-    }
-
-    /* find a place to put it, or where it already is */
-    while (1) {
-        int cmp = strcmp((char *) name, (char *) curp->name);
-        if (cmp < 0) {
-            if (curp->left) {
-                curp = curp->left;
-            } else {
-                return (curp->left = newProduction(name));
-            }
-
-        } else if (cmp > 0) {
-            if (curp->right) {
-                curp = curp->right;
-            } else {
-                return (curp->right = newProduction(name));
-            }
-
-        } else {
-            return curp;
+    size_t hash = productionHash(name);
+    struct Production *curp;
 
+    if (productionTable) {
+        for (curp = productionTable[hash & (productionTableSize - 1)]; curp; curp = curp->next) {
+            if (curp->hash == hash && !strcmp((char *) name, (char *) curp->name))
+                return curp;
         }
     }
+
+    return newProduction(name, hash);
 }
 
 /* remove all productions with the given name */
@@ -92,20 +153,26 @@ void delProduction(const unsigned char *name)
 {
     /* find the relevant production */
     struct Production *curp = getProduction(name),
-                      *curp_left = curp->left,
-                      *curp_right = curp->right;
+                      *curp_next = curp->next;
+    unsigned char *curp_name = curp->name;
+    size_t curp_hash = curp->hash,
+           curp_id = curp->id;
 
-    /* and blank it */
+    /* and blank it, but keep its identity */
     memset(curp, 0, sizeof(struct Production));
-    curp->name = (unsigned char *) GC_STRDUP((char *) name);
-    curp->left = curp_left;
-    curp->right = curp_right;
+    curp->name = curp_name;
+    curp->hash = curp_hash;
+    curp->id = curp_id;
+    curp->next = curp_next;
 }
 
 /* remove ALL productions */
 void delAllProductions()
 {
     productions = NULL;
+    productionCount = productionsSize = 0;
+    productionTable = NULL;
+    productionTableSize = 0;
 }
 
 /* parse using the specified production, not clearing out caches first (assumed
@@ -116,18 +183,48 @@ static struct ParseResult **packratParsePrime(struct ParseContext *ctx,
                                               unsigned char *input, size_t off)
 {
     struct ParseResult **ret;
+    size_t id = production->id;
+    struct PackratProfile *prof = NULL;
+    double start = 0, outerChildTime = 0;
+
+    /* make sure there's a cache for this production ... */
+    if (parseCachesSize <= id) {
+        size_t newsz = productionsSize;
+        if (newsz <= id) newsz = id + 1;
+        parseCaches = GC_REALLOC(parseCaches, newsz * sizeof(struct ParseResult ***));
+        parseCacheSizes = GC_REALLOC(parseCacheSizes, newsz * sizeof(size_t));
+        memset(parseCaches + parseCachesSize, 0, (newsz - parseCachesSize) * sizeof(struct ParseResult ***));
+        memset(parseCacheSizes + parseCachesSize, 0, (newsz - parseCachesSize) * sizeof(size_t));
+        parseCachesSize = newsz;
+    }
 
-    /* make sure the cache is of the appropriate size */
-    if (production->cachesz <= off) {
+    /* ... and that it's of the appropriate size */
+    if (parseCacheSizes[id] <= off) {
         size_t newsz = (off * 2) + 1;
-        production->cache = GC_REALLOC(production->cache,
-                                       newsz * sizeof(struct ParseResult **));
-        production->cachesz = newsz;
+        parseCaches[id] = GC_REALLOC(parseCaches[id],
+                                     newsz * sizeof(struct ParseResult **));
+        memset(parseCaches[id] + parseCacheSizes[id], 0,
+               (newsz - parseCacheSizes[id]) * sizeof(struct ParseResult **));
+        parseCacheSizes[id] = newsz;
     }
 
     /* then check if this is already cached */
-    if (production->cache[off]) {
-        return production->cache[off];
+    if (parseCaches[id][off]) {
+        if (packratProfile) {
+            prof = packratGetProfile(production);
+            prof->invocations++;
+            prof->memoHits++;
+        }
+        return parseCaches[id][off];
+    }
+
+    if (packratProfile) {
+        prof = packratGetProfile(production);
+        prof->invocations++;
+        prof->memoMisses++;
+        outerChildTime = profileChildTime;
+        profileChildTime = 0;
+        start = packratProfileClock();
     }
 
 #ifdef DEBUG
@@ -148,24 +245,150 @@ static struct ParseResult **packratParsePrime(struct ParseContext *ctx,
         ret[0] = NULL;
     }
 
-    /* cache it */
-    production->cache[off] = ret;
+    /* cache it (the production may have recursed into the creation of more caches) */
+    parseCaches[id][off] = ret;
+
+    if (packratProfile) {
+        double elapsed = packratProfileClock() - start;
+        size_t longest = off;
+        int i;
+
+        for (i = 0; ret[i]; i++) {
+            if (ret[i]->consumedTo > longest)
+                longest = ret[i]->consumedTo;
+        }
+        prof->results += i;
+        prof->consumed += longest - off;
+        prof->time += elapsed;
+        prof->selfTime += elapsed - profileChildTime;
+        profileChildTime = outerChildTime + elapsed;
+    }
 
     /* done! */
     return ret;
 }
 
 /* clear out production caches */
-static void clearCaches(struct Production *production)
+static void clearCaches()
+{
+    if (parseCachesSize) {
+        memset(parseCaches, 0, parseCachesSize * sizeof(struct ParseResult ***));
+        memset(parseCacheSizes, 0, parseCachesSize * sizeof(size_t));
+    }
+}
+
+/* get the profiling data for a production */
+struct PackratProfile *packratGetProfile(struct Production *production)
 {
-    production->cachesz = 0;
-    production->cache = NULL;
+    struct PackratProfile *curp;
+    size_t bucket;
+
+    if (production->profile)
+        return production->profile;
 
-    if (production->left)
-        clearCaches(production->left);
+    bucket = production->hash & (PROFILE_TABLE_SIZE - 1);
+    for (curp = profileTable[bucket]; curp; curp = curp->next) {
+        if (!strcmp((char *) curp->name, (char *) production->name))
+            return (production->profile = curp);
+    }
 
-    if (production->right)
-        clearCaches(production->right);
+    /* a new one. These are never freed, so they needn't be GC'd */
+    curp = calloc(1, sizeof(struct PackratProfile));
+    if (curp == NULL) {
+        perror("calloc");
+        exit(1);
+    }
+    curp->name = (unsigned char *) strdup((char *) production->name);
+    curp->next = profileTable[bucket];
+    profileTable[bucket] = curp;
+    profileCount++;
+
+    return (production->profile = curp);
+}
+
+/* get a timestamp for profiling, in nanoseconds */
+double packratProfileClock()
+{
+    struct timespec tspec;
+    clock_gettime(CLOCK_MONOTONIC, &tspec);
+    return tspec.tv_sec * 1000000000.0 + tspec.tv_nsec;
+}
+
+/* compare profiles by time, descending */
+static int profileCmp(const void *l, const void *r)
+{
+    const struct PackratProfile *lp = *((struct PackratProfile **) l),
+                                *rp = *((struct PackratProfile **) r);
+    double ltime = lp->time + lp->actionTime,
+           rtime = rp->time + rp->actionTime;
+
+    if (ltime != rtime) return (ltime < rtime) ? 1 : -1;
+    return strcmp((char *) lp->name, (char *) rp->name);
+}
+
+/* write out the profile, sorted by time, as a table or as JSON */
+void packratProfileReport(FILE *to, int json)
+{
+    struct PackratProfile **sorted, *curp;
+    size_t i, si;
+    unsigned char *c;
+
+    sorted = malloc((profileCount + 1) * sizeof(struct PackratProfile *));
+    if (sorted == NULL) {
+        perror("malloc");
+        return;
+    }
+    for (i = si = 0; i < PROFILE_TABLE_SIZE; i++) {
+        for (curp = profileTable[i]; curp; curp = curp->next)
+            sorted[si++] = curp;
+    }
+    qsort(sorted, profileCount, sizeof(struct PackratProfile *), profileCmp);
+
+    if (json) {
+        fprintf(to, "[\n");
+        for (i = 0; i < profileCount; i++) {
+            curp = sorted[i];
+
+            /* production names may be regexes, so must be escaped */
+            fprintf(to, "  {\"production\": \"");
+            for (c = curp->name; *c; c++) {
+                if (*c == '"' || *c == '\\') {
+                    fprintf(to, "\\%c", *c);
+                } else if (*c < 0x20) {
+                    fprintf(to, "\\u%04x", *c);
+                } else {
+                    fputc(*c, to);
+                }
+            }
+            fprintf(to, "\", \"invocations\": %lu, \"memoHits\": %lu, \"memoMisses\": %lu, "
+                        "\"results\": %lu, \"bytesConsumed\": %lu, \"timeNs\": %.0f, "
+                        "\"selfTimeNs\": %.0f, \"actions\": %lu, \"actionTimeNs\": %.0f}%s\n",
+                    (unsigned long) curp->invocations, (unsigned long) curp->memoHits,
+                    (unsigned long) curp->memoMisses, (unsigned long) curp->results,
+                    (unsigned long) curp->consumed, curp->time, curp->selfTime,
+                    (unsigned long) curp->actions, curp->actionTime,
+                    (i == profileCount - 1) ? "" : ",");
+        }
+        fprintf(to, "]\n");
+
+    } else {
+        fprintf(to, "%-32s %10s %10s %10s %10s %10s %10s %10s %10s %10s\n",
+                "production", "calls", "hits", "misses", "results", "bytes",
+                "time(ms)", "self(ms)", "actions", "act(ms)");
+        for (i = 0; i < profileCount; i++) {
+            curp = sorted[i];
+            fprintf(to, "%-32.32s %10lu %10lu %10lu %10lu %10lu %10.3f %10.3f %10lu %10.3f\n",
+                    (char *) curp->name,
+                    (unsigned long) curp->invocations, (unsigned long) curp->memoHits,
+                    (unsigned long) curp->memoMisses, (unsigned long) curp->results,
+                    (unsigned long) curp->consumed,
+                    curp->time / 1000000.0, curp->selfTime / 1000000.0,
+                    (unsigned long) curp->actions, curp->actionTime / 1000000.0);
+        }
+
+    }
+
+    free(sorted);
 }
 
 /* parse using the specified production */
@@ -189,18 +412,30 @@ struct ParseResult *packratParse(struct ParseContext *ctx,
     }
 
     /* then clear out the caches */
-    clearCaches(productions);
+    clearCaches();
 
     return longest;
 }
 
+/* package up a nonterminal result so that it can be the first element of a
+ * left-recursive alternative */
+static struct ParseResult *wrapLeftRecursive(struct ParseResult *of)
+{
+    struct ParseResult *pr = GC_NEW(struct ParseResult);
+    memcpy(pr, of, sizeof(struct ParseResult));
+    pr->subResults = GC_MALLOC(2 * sizeof(struct ParseResult *));
+    pr->subResults[0] = of;
+    pr->subResults[1] = NULL;
+    return pr;
+}
+
 /* parse a nonterminal (that is, parse some list of child nodes) */
 struct ParseResult **packratNonterminal(struct ParseContext *ctx,
                                         struct Production *production,
                                         unsigned char *file, int line, int col,
                                         unsigned char *input, size_t off)
 {
-    struct Buffer_ParseResult result, lastResult, lastResultP, orResult, orResultP;
+    struct Buffer_ParseResult result, lastResult, lastResultP, orResult, orResultP, roundResult;
     struct Production ***subProductions = (struct Production ***) production->arg;
     struct Production **orProduction;
     int lrec, ors, thens, i, j;
@@ -227,11 +462,16 @@ struct ParseResult **packratNonterminal(struct ParseContext *ctx,
     /* loop over left recursions until we get to a fixed point */
     for (lrec = 0; lastResult.bufused; lrec = 1) {
         INIT_BUFFER(lastResultP);
+        INIT_BUFFER(roundResult);
 
         /* first loop over the ors */
         for (ors = 0; subProductions[ors]; ors++) {
             orProduction = subProductions[ors];
 
+            /* an ordered production stops at the first alternative that succeeds */
+            if (production->mode == PACKRAT_MODE_ORDERED && roundResult.bufused)
+                break;
+
             /* make sure we only do left recursive when we're supposed to */
             if (orProduction[0] == production) {
                 if (!lrec) continue;
@@ -289,22 +529,39 @@ struct ParseResult **packratNonterminal(struct ParseContext *ctx,
                 orResult = orResultP;
             }
 
+            /* committing productions choose from this round's results later */
+            if (production->mode != PACKRAT_MODE_ALL) {
+                WRITE_BUFFER(roundResult, orResult.buf, orResult.bufused);
+                continue;
+            }
+
             /* now that one of the or's has succeeded, we can add it to the overall result */
             WRITE_BUFFER(result, orResult.buf, orResult.bufused);
 
             /* now package up this result for left recursion */
             for (i = 0; i < orResult.bufused; i++) {
-                pr = GC_NEW(struct ParseResult);
-                memcpy(pr, orResult.buf[i], sizeof(struct ParseResult));
-                pr->subResults = GC_MALLOC(2 * sizeof(struct ParseResult *));
-                pr->subResults[0] = orResult.buf[i];
-                pr->subResults[1] = NULL;
-                orResult.buf[i] = pr;
+                orResult.buf[i] = wrapLeftRecursive(orResult.buf[i]);
             }
             WRITE_BUFFER(lastResultP, orResult.buf, orResult.bufused);
 
         }
 
+        /* commit to the longest result of this round, which supersedes
+         * anything from previous rounds, since it extends them */
+        if (roundResult.bufused) {
+            pr = roundResult.buf[0];
+            for (i = 1; i < roundResult.bufused; i++) {
+                if (roundResult.buf[i]->consumedTo > pr->consumedTo)
+                    pr = roundResult.buf[i];
+            }
+
+            result.bufused = 0;
+            WRITE_BUFFER(result, &pr, 1);
+
+            pr = wrapLeftRecursive(pr);
+            WRITE_BUFFER(lastResultP, &pr, 1);
+        }
+
         lastResult = lastResultP;
     }
 
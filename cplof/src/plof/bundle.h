@@ -0,0 +1,58 @@
+/*
+ * Bundles of PSL appended to an executable
+ *
+ * Copyright (C) 2010 Gregor Richards
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef PLOF_BUNDLE_H
+#define PLOF_BUNDLE_H
+
+#include <stdio.h>
+
+#include "plof/plof.h"
+
+#define PLOF_BUNDLE_MAGIC "\x9E\x50\x42\x4E\x17\xF2\x58\x8C"
+
+/* A file in a bundle. Files marked run are PSL files run in order at
+ * startup, the rest are there to be included */
+struct PlofBundleFile {
+    int run;
+    size_t namelen, length;
+    unsigned char *name, *data;
+};
+
+/* the files of the loaded bundle, if any */
+extern struct PlofBundleFile *plofBundleFiles;
+extern size_t plofBundleFileCount;
+
+/* Look for a bundle at the end of the given file (the running executable) and
+ * load it. Returns the number of files in the bundle,
+ * or 0 if there isn't one */
+size_t plofLoadBundle(const char *exe);
+
+/* find a file by name in the loaded bundle, returning its data or NULL */
+unsigned char *plofBundleFind(size_t namelen, unsigned char *name, size_t *length);
+
+/* append a bundle of these files to to, returning 0 if the writes fail */
+int plofWriteBundle(FILE *to, size_t count, struct PlofBundleFile *files);
+
+#endif
@@ -0,0 +1,52 @@
+/*
+ * Heap images, snapshots of an initialized runtime
+ *
+ * Copyright (C) 2010 Gregor Richards
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef PLOF_IMAGE_H
+#define PLOF_IMAGE_H
+
+#include <stdio.h>
+
+#include "plof/plof.h"
+
+#define PLOF_IMAGE_MAGIC "\x9E\x50\x49\x4D\x17\xF2\x58\x8C"
+
+/* return true if this buffer points to a heap image */
+int isPlofImage(size_t sz, unsigned char *buf);
+
+/* Write out an image of everything reachable from plofNull, plofGlobal,
+ * context and the objects the intrinsics hold on to, along with extra, which
+ * is kept verbatim (cplof uses it for the grammar). stdhash is the plofHash of
+ * the std.psl the heap was built from, or 0. Compiled code isn't kept, it's
+ * recompiled on first use. Returns 0 (with an error message) if the heap can't
+ * be imaged */
+int plofWriteImage(FILE *to, struct PlofObject *context, size_t stdhash, size_t extralen, unsigned char *extra);
+
+/* Read an image written by plofWriteImage with the same build, setting
+ * plofNull, plofGlobal and the intrinsics' objects. Returns the context, or
+ * NULL (with an error message) if the image is bad or was made with a std.psl
+ * other than the one stdhash is the hash of (0 to not check). extra is set to
+ * the image's extra data */
+struct PlofObject *plofReadImage(size_t sz, unsigned char *buf, size_t stdhash, struct Buffer_psl *extra);
+
+#endif
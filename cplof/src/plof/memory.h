@@ -39,12 +39,67 @@ struct PlofRawData *newPlofRawData(size_t length);
 /* Allocate a PlofRawData with non-atomic data */
 struct PlofRawData *newPlofRawDataNonAtomic(size_t length);
 
+/* Concatenate two PlofRawDatas. Long results are ropes, so that repeated
+ * concatenation is linear */
+struct PlofRawData *plofRawConcat(struct PlofRawData *left, struct PlofRawData *right);
+
+/* Flatten a rope PlofRawData in place, so that its data is available */
+struct PlofRawData *plofRawFlatten(struct PlofRawData *rd);
+
+/* Get a slice of a (flat) PlofRawData. Long slices are views of of's buffer
+ * rather than copies */
+struct PlofRawData *plofRawSlice(struct PlofRawData *of, size_t start, size_t length);
+
+/* Make a PlofRawData of data which mustn't be written to (such as a loaded
+ * file). It's treated as a view */
+struct PlofRawData *newPlofRawDataView(size_t length, unsigned char *data);
+
+/* Give a view its own NUL-terminated copy of its data, so that it can be
+ * written to or used as a C string */
+struct PlofRawData *plofRawUnshare(struct PlofRawData *rd);
+
 /* Allocate a PlofArrayData */
 struct PlofArrayData *newPlofArrayData(size_t length);
 
 /* Allocate a PlofLocalsData */
 struct PlofArrayData *newPlofLocalsData(size_t length);
 
+/* Set the length of an array, growing its capacity geometrically if needed.
+ * New elements are null */
+void plofArrayResize(struct PlofArrayData *ad, size_t length);
+
+/* Append the elements of one array to another (which may be the same array) */
+void plofArrayAppend(struct PlofArrayData *ad, struct PlofArrayData *from);
+
+/* Allocate a zeroed PlofTypedData of the given psl_ctype, or NULL if that kind
+ * isn't supported */
+struct PlofTypedData *newPlofTypedData(int kind, size_t length);
+
+/* Get or set an element of a typed array (index must be in bounds) */
+ptrdiff_t plofTypedGet(struct PlofTypedData *td, size_t index);
+void plofTypedSet(struct PlofTypedData *td, size_t index, ptrdiff_t val);
+
+/* Set elements [start, end) of a typed array to val */
+void plofTypedFill(struct PlofTypedData *td, ptrdiff_t val, size_t start, size_t end);
+
+/* Copy count elements from src at soff into dst at doff, converting if the
+ * kinds differ. The ranges may overlap */
+void plofTypedCopy(struct PlofTypedData *dst, size_t doff,
+                   struct PlofTypedData *src, size_t soff, size_t count);
+
+/* Apply the integer operation op (psl_add, psl_sub, psl_mul, psl_and, psl_or
+ * or psl_xor) elementwise, dst[i] = dst[i] op src[i], or dst[i] op val if src
+ * is NULL. Returns 0 if op isn't supported */
+int plofTypedArith(struct PlofTypedData *dst, struct PlofTypedData *src, ptrdiff_t val, int op);
+
+/* Reduce a typed array with op (psl_add, psl_mul, psl_and, psl_or, psl_xor,
+ * or psl_lt for the minimum and psl_gt for the maximum). Returns 0 if op isn't
+ * supported */
+int plofTypedReduce(struct PlofTypedData *td, int op, ptrdiff_t *into);
+
+/* Allocate an empty PlofMapData */
+struct PlofMapData *newPlofMapData();
+
 /* Allocate objects with data inline */
 struct PlofObject *newPlofObjectWithRaw(size_t length);
 struct PlofObject *newPlofObjectWithArray(size_t length);
@@ -25,6 +25,8 @@
 #ifndef PACKRAT_H
 #define PACKRAT_H
 
+#include <stdio.h>
+
 struct Production;
 struct ParseContext;
 
@@ -50,18 +52,18 @@ struct ParseContext {
 };
 
 /* A production. Could be a terminal or a nonterminal, includes a
- * reference to the relevant parsing function and arg. Grammar elements form a
- * tree for easy indexing */
+ * reference to the relevant parsing function and arg. Productions are interned
+ * in a hash table by name, and numbered densely as they're created */
 struct Production {
-    /* the name of this production */
+    /* the name of this production, and its hash */
     unsigned char *name;
+    size_t hash;
 
-    /* the tree */
-    struct Production *left, *right;
+    /* the dense ID of this production, an index into productions */
+    size_t id;
 
-    /* the memoization cache */
-    size_t cachesz;
-    struct ParseResult ***cache;
+    /* the next production in this hash bucket */
+    struct Production *next;
 
     /* the underlying parser function */
     Parser parser;
@@ -69,11 +71,27 @@ struct Production {
     /* the argument, and user argument */
     void *arg, *userarg;
 
+    /* how ambiguity is handled, one of the PACKRAT_MODE_* values below */
+    int mode;
+
+    /* profiling data, if profiling is on (found by name when first needed) */
+    struct PackratProfile *profile;
+
     /* any subproductions, for clearing */
     struct Production **sub;
 };
 
-extern struct Production *productions;
+/* Ambiguity modes for productions. By default every parse is kept, but
+ * ordered productions commit to the first alternative that succeeds (as in a
+ * PEG), and longest productions commit to their longest parse. Either way,
+ * such a production yields at most one result at any offset */
+#define PACKRAT_MODE_ALL        0
+#define PACKRAT_MODE_ORDERED    1
+#define PACKRAT_MODE_LONGEST    2
+
+/* all productions, indexed by ID */
+extern struct Production **productions;
+extern size_t productionCount;
 
 /* A parsing result, including the particular production, file, etc */
 struct ParseResult {
@@ -132,4 +150,36 @@ struct Production *newPackratRegexTerminal(unsigned char *name, unsigned char *r
 /* warn when a nonterminal is ambiguous (should usually be off, since ambiguities are OK) */
 extern int packratWarnAmbiguous;
 
+/* profiling data for a production. Since productions are recreated on every
+ * grammar commit, this is kept by name, and survives commits */
+struct PackratProfile {
+    unsigned char *name;
+    struct PackratProfile *next;
+
+    /* memo hits + memo misses = invocations */
+    size_t invocations, memoHits, memoMisses;
+
+    /* results produced and bytes consumed (by the longest result) on misses */
+    size_t results, consumed;
+
+    /* time spent parsing (with and without subproductions), in nanoseconds */
+    double time, selfTime;
+
+    /* semantic actions run for this production by PRP, and their time */
+    size_t actions;
+    double actionTime;
+};
+
+/* profile the parser (should usually be off, since it slows parsing down) */
+extern int packratProfile;
+
+/* get the profiling data for a production */
+struct PackratProfile *packratGetProfile(struct Production *production);
+
+/* get a timestamp for profiling, in nanoseconds */
+double packratProfileClock(void);
+
+/* write out the profile, sorted by time, as a table or as JSON */
+void packratProfileReport(FILE *to, int json);
+
 #endif
@@ -36,6 +36,7 @@
 BUFFER(psl, unsigned char);
 
 struct PlofObject;
+struct PlofRawData;
 struct PlofReturn;
 struct PlofOHashTable;
 struct PlofData;
@@ -43,6 +44,14 @@ struct PlofData;
 /* search path for include, should be a null-terminated array of strings */
 extern unsigned char **plofIncludePaths;
 
+/* Find a file for include, in the bundle or on the include path, returning
+ * its data or NULL. What's found is cached */
+struct PlofRawData *plofInclude(size_t namelen, unsigned char *name);
+
+/* Forget what include has found (and what it parsed to), as the includeclear
+ * instruction does */
+void plofIncludeCacheClear(void);
+
 /* should we load intrinsics? */
 extern int plofLoadIntrinsics;
 
@@ -50,6 +59,8 @@ extern int plofLoadIntrinsics;
 #define PLOF_DATA_RAW           1
 #define PLOF_DATA_ARRAY         2
 #define PLOF_DATA_LOCALS        3
+#define PLOF_DATA_TYPED         4
+#define PLOF_DATA_MAP           5
 
 /* Function for getting a value from the hash table in an object */
 struct PlofObject *plofRead(struct PlofObject *obj, unsigned char *name, size_t namehash);
@@ -122,9 +133,16 @@ struct PlofData {
 /* Standard Plof raw data
  * type: Should always be PLOF_DATA_RAW
  * length: The length of the data
- * data: The data itself (of course)
+ * data: The data itself (of course), or NULL if this is a rope
+ * hash: The hash of the data, or 0 if it hasn't been computed
  * idata: Any data stored by the interpreter (e.g. a compiled version)
- * proc: The intrinsic (compiled) function */
+ * proc: The intrinsic (compiled) function
+ * left, right: If this is a rope, the data is the concatenation of these, and
+ *              is only flattened into data when it's needed
+ * base: If this is a view, the raw data whose buffer data points into. Views
+ *       are not NUL-terminated, and get their own copy if they need to be
+ * inl: Storage for data when it's allocated along with the header (this is
+ *      really as long as the data and its terminator) */
 struct PlofRawData {
     int type;
     size_t length;
@@ -132,18 +150,53 @@ struct PlofRawData {
     size_t hash;
     void *idata;
     PlofFunction proc;
+    struct PlofRawData *left, *right;
+    struct PlofRawData *base;
+    unsigned char inl[1];
 };
 
 /* Array data
  * type: Should always be PLOF_DATA_ARRAY
  * length: The length of the array
+ * capacity: The number of elements allocated for data (>= length)
  * data: The array */
 struct PlofArrayData {
     int type;
-    size_t length;
+    size_t length, capacity;
     struct PlofObject **data;
 };
 
+/* Typed array data, packed numbers rather than objects
+ * type: Should always be PLOF_DATA_TYPED
+ * kind: The element type, as a psl_ctype (uint8, int32 or int64)
+ * width: The size of each element in bytes
+ * length: The number of elements
+ * data: The elements, contiguous and in native byte order (really length *
+ *       width bytes long) */
+struct PlofTypedData {
+    int type;
+    int kind;
+    size_t width;
+    size_t length;
+    unsigned char data[1];
+};
+
+/* Map data, a hash table keyed by raw data (compared by content) or integers
+ * type: Should always be PLOF_DATA_MAP
+ * length: The number of entries
+ * capacity: The number of slots, a power of two
+ * slots: The table, open addressed with linear probing. Empty slots have a
+ *        NULL key */
+struct PlofMapSlot {
+    size_t hash;
+    struct PlofObject *key, *value;
+};
+struct PlofMapData {
+    int type;
+    size_t length, capacity;
+    struct PlofMapSlot *slots;
+};
+
 /* Major Plof constants */
 extern struct PlofObject *plofNull, *plofGlobal;
 
@@ -172,4 +225,16 @@ void plofObjCopy(struct PlofObject *to, struct PlofObject *from);
 /* Make an array of the list of members of an object (for 'members') */
 struct PlofArrayData *plofMembers(struct PlofObject *of);
 
+/* Map operations. Keys must be raw data or integers. Get returns NULL if the
+ * key isn't there, and remove returns 0 */
+struct PlofObject *plofMapGet(struct PlofMapData *md, struct PlofObject *key);
+void plofMapPut(struct PlofMapData *md, struct PlofObject *key, struct PlofObject *value);
+int plofMapRemove(struct PlofMapData *md, struct PlofObject *key);
+
+/* Make an array of the keys of a map */
+struct PlofArrayData *plofMapKeys(struct PlofMapData *md);
+
+/* Make a name object for a member name, a view of the name */
+struct PlofObject *plofMemberName(unsigned char *name, size_t namehash);
+
 #endif
@@ -0,0 +1,75 @@
+/*
+ * Sampling profiler for PSL procedures
+ *
+ * Copyright (C) 2010 Gregor Richards
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef PLOF_PROFILE_H
+#define PLOF_PROFILE_H
+
+#include "plof/plof.h"
+
+/* A procedure being interpreted (rd is NULL for anonymous PSL). interpretPSL
+ * keeps a list of these for the profiler to walk when it takes a sample. dfile
+ * and dline point at the source location it's currently running, which it
+ * updates from dsrcfile and dsrcline as it goes if compiled with --debug, so a
+ * sample names the line being run rather than where the procedure starts */
+struct PlofProfileFrame {
+    volatile struct PlofProfileFrame *caller;
+    struct PlofRawData *rd;
+    unsigned char **dfile;
+    ptrdiff_t *dline;
+};
+
+/* the innermost procedure being interpreted */
+extern volatile struct PlofProfileFrame *volatile plofProfileTop;
+
+#define PLOF_PROFILE_ENTER(frame, prd, file, line) do { \
+    (frame).caller = plofProfileTop; \
+    (frame).rd = (prd); \
+    (frame).dfile = (file); \
+    (frame).dline = (line); \
+    plofProfileTop = &(frame); \
+} while (0)
+#define PLOF_PROFILE_LEAVE(frame) (plofProfileTop = (frame).caller)
+
+/* Start sampling the procedures being interpreted on SIGPROF, to be written
+ * to the named file by plofProfileStop as folded stacks (one line per distinct
+ * stack, outermost procedure first, separated by ';', then the number of
+ * samples), which flamegraph tools take. Returns 0 if profiling isn't
+ * possible */
+int plofProfileStart(const char *file);
+
+/* stop sampling and write out the profile, if started */
+void plofProfileStop();
+
+/* If set, count every instruction run, every pair of instructions run one
+ * after the other and every call of each procedure. This only affects PSL
+ * compiled after it's set, so it must be set before any PSL is run */
+extern int plofCountOps;
+
+/* count a call to a procedure (NULL for anonymous PSL) */
+void plofCountCall(struct PlofRawData *rd);
+
+/* write the counts to stderr, if counting */
+void plofCountReport();
+
+#endif
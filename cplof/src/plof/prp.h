@@ -38,6 +38,13 @@ struct PRPResult {
     unsigned int rline, rcol;
 };
 
+/* A production name given to gadd may be prefixed with one of these markers to
+ * make the production commit to a single parse: ordered productions take the
+ * first alternative which succeeds, longest productions take the longest
+ * parse. Any other gadd to the same production inherits the mode */
+#define PRP_ORDERED_MARKER '<'
+#define PRP_LONGEST_MARKER '>'
+
 /* These correspond directly to underlying PSL instructions */
 void gadd(unsigned char *name, unsigned char **target,
           size_t prepsllen, unsigned char *prepsl,
@@ -45,6 +52,15 @@ void gadd(unsigned char *name, unsigned char **target,
 void grem(unsigned char *name);
 void gcommit(void);
 
+/* The gadds that make the committed grammar, then any changes since, in a
+ * form that prpReplayGrammar can redo (building the grammar once), so that
+ * the grammar can be saved along with a heap image */
+struct Buffer_psl prpGrammarLog(void);
+void prpReplayGrammar(size_t len, unsigned char *log);
+
+/* A number which changes whenever the grammar does */
+size_t prpGrammarGeneration(void);
+
 /* Parse some part of PSL code */
 struct PRPResult parseOne(unsigned char *code, unsigned char *top, unsigned char *file,
                           unsigned int line, unsigned int column);
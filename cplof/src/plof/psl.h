@@ -66,6 +66,19 @@
 #define psl_local     0x28
 #define psl_localset  0x29
 #define psl_nullarray 0x2A
+#define psl_tarray    0x2B
+#define psl_tindex    0x2C
+#define psl_tindexset 0x2D
+#define psl_tfill     0x2E
+#define psl_tcopy     0x2F
+#define psl_tarith    0x30
+#define psl_treduce   0x31
+#define psl_traw      0x32
+#define psl_map       0x33
+#define psl_mapget    0x34
+#define psl_mapset    0x35
+#define psl_mapdel    0x36
+#define psl_mapkeys   0x37
 #define psl_rawlength 0x60
 #define psl_slice     0x61
 #define psl_rawcmp    0x62
@@ -114,6 +127,7 @@
 #define psl_print     0xE0
 #define psl_debug     0xE1
 #define psl_intrinsic 0xE2
+#define psl_includeclear 0xEC
 #define psl_trap      0xED
 #define psl_include   0xEE
 #define psl_parse     0xEF
@@ -35,9 +35,22 @@
 #define PSL_SECTION_STRIPPED_PROGRAM_DATA       2
 #define PSL_SECTION_RAW_DATA_TABLE              3
 
+/* Load the whole of a file into the heap, in one read where its size is
+ * known. The result may be shared by views, so must not be written to, and
+ * isn't NUL-terminated */
+unsigned char *pslLoadFile(FILE *fh, size_t *sz);
+
 /* return true if this buffer points to a PSL file */
 int isPSLFile(size_t sz, unsigned char *buf);
 
+/* return true if this is whole PSL, i.e. every instruction's data is within
+ * it. Code blocks may instead be fragments of PSL */
+int isWholePSL(size_t sz, unsigned char *buf);
+
+/* return true if this PSL has immediates of its own (not just in code
+ * blocks) */
+int pslHasImmediate(size_t sz, unsigned char *buf);
+
 /* read in the PSL from a PSL file */
 struct Buffer_psl readPSLFile(size_t sz, unsigned char *buf);
 
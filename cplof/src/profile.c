@@ -0,0 +1,381 @@
+/*
+ * Sampling profiler for PSL procedures
+ *
+ * Copyright (C) 2010 Gregor Richards
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef HAVE_CONFIG_H
+#include "../config.h"
+#else
+#include "basicconfig.h"
+#endif
+
+#ifdef HAVE_SETITIMER
+#include <signal.h>
+#include <sys/time.h>
+#endif
+
+#include "interp.h"
+#include "plof/memory.h"
+#include "plof/plof.h"
+#include "plof/profile.h"
+
+volatile struct PlofProfileFrame *volatile plofProfileTop = NULL;
+
+/* write out the name of a procedure without source information, which is a
+ * hash of its code (NULL is anonymous PSL) */
+static void profileWriteProcedure(FILE *out, struct PlofRawData *rd)
+{
+    if (rd) {
+        fprintf(out, "[%s:%08lx]", rd->proc ? "intrinsic" : "psl",
+                (unsigned long) (plofHash(rd->length, rd->data) & 0xFFFFFFFFUL));
+    } else {
+        fprintf(out, "[anonymous]");
+    }
+}
+
+#ifdef HAVE_SETITIMER
+
+/* microseconds of CPU time between samples */
+#ifndef PLOF_PROFILE_INTERVAL
+#define PLOF_PROFILE_INTERVAL 1000
+#endif
+
+/* stacks deeper than this lose their outermost procedures */
+#define PROFILE_MAX_DEPTH 256
+
+/* samples are counted per distinct stack as they're taken, since the signal
+ * handler can't allocate. Samples of new stacks which don't fit are dropped */
+#define PROFILE_MAX_FRAMES (1<<18)
+#define PROFILE_STACK_BITS 14
+#define PROFILE_STACK_SIZE (1<<PROFILE_STACK_BITS)
+#define PROFILE_STACK_MASK (PROFILE_STACK_SIZE - 1)
+
+/* a procedure as sampled, with the line it was running */
+struct ProfileSample {
+    struct PlofRawData *rd;
+    unsigned char *dfile;
+    ptrdiff_t dline;
+};
+
+/* a distinct stack, innermost procedure first, and how often it was seen */
+struct ProfileStack {
+    size_t hash, start, depth, count;
+};
+
+static const char *profileFile = NULL;
+static int profiling = 0;
+
+/* the sampled procedures are in GC'd memory so that they stay alive */
+static struct ProfileSample *profileFrames = NULL;
+static size_t profileFramesUsed = 0;
+static struct ProfileStack *profileStacks = NULL;
+static size_t profileStacksUsed = 0;
+static size_t profileSamples = 0, profileDropped = 0;
+
+/* take a sample */
+static void profileSignal(int sig)
+{
+    struct ProfileSample sample[PROFILE_MAX_DEPTH];
+    volatile struct PlofProfileFrame *frame;
+    struct ProfileStack *st;
+    size_t depth, hash, slot;
+
+    profileSamples++;
+
+    hash = 0;
+    for (depth = 0, frame = plofProfileTop;
+         frame && depth < PROFILE_MAX_DEPTH;
+         depth++, frame = frame->caller) {
+        sample[depth].rd = frame->rd;
+        sample[depth].dfile = *frame->dfile;
+        sample[depth].dline = *frame->dline;
+        hash = (hash << 5) + hash + ((size_t) frame->rd >> 3) + (size_t) sample[depth].dline;
+    }
+
+    /* count it with the same stack if we've seen it */
+    for (slot = hash & PROFILE_STACK_MASK;
+         profileStacks[slot].count;
+         slot = (slot + 1) & PROFILE_STACK_MASK) {
+        st = &profileStacks[slot];
+        if (st->hash == hash && st->depth == depth &&
+            !memcmp(profileFrames + st->start, sample, depth * sizeof(struct ProfileSample))) {
+            st->count++;
+            return;
+        }
+    }
+
+    /* otherwise it's new */
+    if (profileStacksUsed >= PROFILE_STACK_SIZE / 4 * 3 ||
+        profileFramesUsed + depth > PROFILE_MAX_FRAMES) {
+        profileDropped++;
+        return;
+    }
+    st = &profileStacks[slot];
+    st->hash = hash;
+    st->start = profileFramesUsed;
+    st->depth = depth;
+    st->count = 1;
+    memcpy(profileFrames + profileFramesUsed, sample, depth * sizeof(struct ProfileSample));
+    profileFramesUsed += depth;
+    profileStacksUsed++;
+}
+
+/* write out the name of a sampled procedure: the source location it was
+ * running if known, else as profileWriteProcedure */
+static void profileWriteName(FILE *out, struct ProfileSample *ps)
+{
+    unsigned char *c;
+
+    if (ps->dfile) {
+        /* ';' and ' ' separate the fields of folded stacks */
+        for (c = ps->dfile; *c; c++)
+            fputc((*c == ';' || *c == ' ') ? '_' : *c, out);
+        if (ps->dline >= 0)
+            fprintf(out, ":%d", (int) ps->dline + 1);
+
+    } else {
+        profileWriteProcedure(out, ps->rd);
+
+    }
+}
+
+int plofProfileStart(const char *file)
+{
+    struct sigaction sa;
+    struct itimerval it;
+
+    if (profiling) return 1;
+
+    profileFile = file;
+    profileFrames = (struct ProfileSample *) GC_MALLOC(PROFILE_MAX_FRAMES * sizeof(struct ProfileSample));
+    profileStacks = (struct ProfileStack *) GC_MALLOC_ATOMIC(PROFILE_STACK_SIZE * sizeof(struct ProfileStack));
+    memset(profileStacks, 0, PROFILE_STACK_SIZE * sizeof(struct ProfileStack));
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = profileSignal;
+    sa.sa_flags = SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    if (sigaction(SIGPROF, &sa, NULL) != 0) {
+        perror("sigaction");
+        return 0;
+    }
+
+    it.it_interval.tv_sec = 0;
+    it.it_interval.tv_usec = PLOF_PROFILE_INTERVAL;
+    it.it_value = it.it_interval;
+    if (setitimer(ITIMER_PROF, &it, NULL) != 0) {
+        perror("setitimer");
+        return 0;
+    }
+
+    profiling = 1;
+    return 1;
+}
+
+void plofProfileStop()
+{
+    struct itimerval it;
+    struct ProfileStack *st;
+    FILE *out;
+    size_t i, j;
+
+    if (!profiling) return;
+    profiling = 0;
+
+    memset(&it, 0, sizeof(it));
+    setitimer(ITIMER_PROF, &it, NULL);
+    signal(SIGPROF, SIG_IGN);
+
+    out = fopen(profileFile, "w");
+    if (out == NULL) {
+        perror(profileFile);
+        return;
+    }
+
+    for (i = 0; i < PROFILE_STACK_SIZE; i++) {
+        st = &profileStacks[i];
+        if (!st->count) continue;
+
+        /* outermost first */
+        if (st->depth == 0) fprintf(out, "[native]");
+        for (j = st->depth; j > 0; j--) {
+            profileWriteName(out, profileFrames + st->start + j - 1);
+            if (j > 1) fputc(';', out);
+        }
+        fprintf(out, " %lu\n", (unsigned long) st->count);
+    }
+
+    fclose(out);
+
+    if (profileDropped)
+        fprintf(stderr, "Profiler: %lu of %lu samples dropped, out of space for stacks.\n",
+                (unsigned long) profileDropped, (unsigned long) profileSamples);
+}
+
+#else
+
+int plofProfileStart(const char *file)
+{
+    fprintf(stderr, "Profiling isn't supported on this platform.\n");
+    return 0;
+}
+
+void plofProfileStop() {}
+
+#endif
+
+
+/* Instruction and call counting */
+int plofCountOps = 0;
+unsigned long *plofOpCounts = NULL;
+unsigned long (*plofOpPairCounts)[label_psl_last] = NULL;
+int plofOpLast = label_psl_nop;
+
+/* the names of instructions, by label */
+static const char *countOpNames[] = {
+#define FOREACH(inst) #inst,
+#include "psl_internal_inst.h"
+#undef FOREACH
+    NULL
+};
+
+/* calls per procedure, in an open hash table by procedure (which is in GC'd
+ * memory so that they stay alive) */
+static struct PlofRawData **countProcs = NULL;
+static unsigned long *countCalls = NULL;
+static size_t countProcsSize = 0, countProcsUsed = 0;
+static unsigned long countAnonymous = 0;
+
+/* find a procedure's slot in the table */
+static size_t countProcSlot(struct PlofRawData *rd)
+{
+    size_t slot;
+    for (slot = ((size_t) rd >> 4) & (countProcsSize - 1);
+         countProcs[slot] && countProcs[slot] != rd;
+         slot = (slot + 1) & (countProcsSize - 1));
+    return slot;
+}
+
+void plofCountCall(struct PlofRawData *rd)
+{
+    size_t slot, i;
+
+    if (!rd) {
+        countAnonymous++;
+        return;
+    }
+
+    /* keep the table at most half full */
+    if (countProcsUsed >= countProcsSize / 2) {
+        struct PlofRawData **oldProcs = countProcs;
+        unsigned long *oldCalls = countCalls;
+        size_t oldSize = countProcsSize;
+
+        countProcsSize = oldSize ? oldSize * 2 : 1024;
+        countProcs = (struct PlofRawData **) GC_MALLOC(countProcsSize * sizeof(struct PlofRawData *));
+        countCalls = (unsigned long *) GC_MALLOC_ATOMIC(countProcsSize * sizeof(unsigned long));
+        memset(countProcs, 0, countProcsSize * sizeof(struct PlofRawData *));
+        memset(countCalls, 0, countProcsSize * sizeof(unsigned long));
+
+        for (i = 0; i < oldSize; i++) {
+            if (oldProcs[i]) {
+                slot = countProcSlot(oldProcs[i]);
+                countProcs[slot] = oldProcs[i];
+                countCalls[slot] = oldCalls[i];
+            }
+        }
+    }
+
+    slot = countProcSlot(rd);
+    if (!countProcs[slot]) {
+        countProcs[slot] = rd;
+        countProcsUsed++;
+    }
+    countCalls[slot]++;
+}
+
+/* sort counts, largest first */
+static unsigned long *countSortBy;
+static int countCmp(const void *lv, const void *rv)
+{
+    unsigned long l = countSortBy[*(size_t *) lv], r = countSortBy[*(size_t *) rv];
+    return (l < r) ? 1 : (l > r) ? -1 : 0;
+}
+
+/* sort the nonzero counts in counts, returning their indexes */
+static size_t *countSorted(size_t count, unsigned long *counts, size_t *nonzero)
+{
+    size_t *idx, i, n;
+
+    idx = (size_t *) GC_MALLOC_ATOMIC((count + 1) * sizeof(size_t));
+    for (i = n = 0; i < count; i++)
+        if (counts[i]) idx[n++] = i;
+
+    countSortBy = counts;
+    qsort(idx, n, sizeof(size_t), countCmp);
+    *nonzero = n;
+    return idx;
+}
+
+/* how many pairs and procedures to report */
+#define COUNT_REPORT_TOP 50
+
+void plofCountReport()
+{
+    size_t *idx, n, i;
+    unsigned long total = 0;
+
+    if (!plofCountOps || !plofOpCounts) return;
+
+    /* instructions */
+    idx = countSorted(label_psl_last, plofOpCounts, &n);
+    for (i = 0; i < n; i++) total += plofOpCounts[idx[i]];
+    fprintf(stderr, "%12s %7s  %s\n", "executed", "%", "instruction");
+    for (i = 0; i < n; i++)
+        fprintf(stderr, "%12lu %6.2f%%  %s\n", plofOpCounts[idx[i]],
+                100.0 * plofOpCounts[idx[i]] / total, countOpNames[idx[i]]);
+
+    /* pairs */
+    idx = countSorted(label_psl_last * label_psl_last, &plofOpPairCounts[0][0], &n);
+    fprintf(stderr, "\n%12s %7s  %s\n", "executed", "%", "instruction pair");
+    for (i = 0; i < n && i < COUNT_REPORT_TOP; i++)
+        fprintf(stderr, "%12lu %6.2f%%  %s %s\n", (&plofOpPairCounts[0][0])[idx[i]],
+                100.0 * (&plofOpPairCounts[0][0])[idx[i]] / total,
+                countOpNames[idx[i] / label_psl_last], countOpNames[idx[i] % label_psl_last]);
+
+    /* procedures */
+    fprintf(stderr, "\n%12s  %s\n", "calls", "procedure");
+    if (countAnonymous)
+        fprintf(stderr, "%12lu  [anonymous]\n", countAnonymous);
+    if (countProcsSize) {
+        idx = countSorted(countProcsSize, countCalls, &n);
+        for (i = 0; i < n && i < COUNT_REPORT_TOP; i++) {
+            fprintf(stderr, "%12lu  ", countCalls[idx[i]]);
+            profileWriteProcedure(stderr, countProcs[idx[i]]);
+            fprintf(stderr, "\n");
+        }
+    }
+}
@@ -41,12 +41,16 @@
 #include "plof/prp.h"
 
 BUFFER(target, unsigned char **);
-BUFFER(psl_array, struct Buffer_psl);
+BUFFER(action, struct PlofObject *);
 
+/* a production as the user specified it. Each target has a pre- and
+ * post-action, which are kept as PSL procedure objects so that they're only
+ * compiled once */
 struct UProduction {
     unsigned char *name;
     struct Buffer_target target;
-    struct Buffer_psl_array psl;
+    struct Buffer_action psl;
+    int mode;
     struct UProduction *right, *left;
 };
 
@@ -54,32 +58,66 @@ struct PlofObject *parseHelper(unsigned char *code, struct ParseResult *pr, stru
 
 static struct UProduction *getUProduction(unsigned char *name);
 
+static int productionMode(unsigned char **name);
+
 static struct UProduction *newUProduction(unsigned char *name);
 
 static void gcommitRecurse(struct UProduction *curup);
 
+static struct PlofObject *newAction(size_t psllen, unsigned char *psl);
+
 static struct UProduction *new_grammar = NULL;
 
+/* the grammar's changes, for prpGrammarLog. Each is an operation (PRP_LOG_*)
+ * followed by its arguments as bignum-length-prefixed strings, with gadd's
+ * targets preceded by their count. On each commit it's rewritten as just the
+ * gadds that make the grammar as it now is, so it doesn't grow with history */
+#define PRP_LOG_GADD    0
+#define PRP_LOG_GREM    1
+#define PRP_LOG_GCOMMIT 2
+static struct Buffer_psl grammarLog;
+
+/* how many commits there have been, for prpGrammarGeneration */
+static size_t grammarGeneration = 0;
+
+static void logGrammarInt(size_t val);
+
+static void logGrammarStr(size_t len, unsigned char *str);
+
+static void logGrammarRecurse(struct UProduction *curp);
+
 int prpDebug = 0;
 
 void gadd(unsigned char *name, unsigned char **target,
           size_t prepsllen, unsigned char *prepsl,
           size_t postpsllen, unsigned char *postpsl)
 {
-    struct UProduction *curp = getUProduction(name);
-    struct Buffer_psl prepslbuf, postpslbuf;
-
-    prepslbuf.buf = prepsl;
-    prepslbuf.bufsz = prepslbuf.bufused = prepsllen;
-
-    postpslbuf.buf = postpsl;
-    postpslbuf.bufsz = postpslbuf.bufused = postpsllen;
+    int mode;
+    struct UProduction *curp;
+    size_t i;
+
+    logGrammarInt(PRP_LOG_GADD);
+    logGrammarStr(strlen((char *) name), name);
+    for (i = 0; target[i]; i++);
+    logGrammarInt(i);
+    for (i = 0; target[i]; i++)
+        logGrammarStr(strlen((char *) target[i]), target[i]);
+    logGrammarStr(prepsllen, prepsl);
+    logGrammarStr(postpsllen, postpsl);
+
+    mode = productionMode(&name);
+    curp = getUProduction(name);
 
 #ifdef DEBUG
     fprintf(stderr, "PRP: gadd %s\n", name);
 #endif
 
-    if(BUFFER_SPACE(curp->target) < 1)
+    /* a marked name changes the mode of the whole production */
+    if (mode != PACKRAT_MODE_ALL)
+        curp->mode = mode;
+
+    /* the targets are NULL-terminated, so leave room for the terminator */
+    while (BUFFER_SPACE(curp->target) < 2)
         EXPAND_BUFFER(curp->target);
     STEP_BUFFER(curp->target, 1);
     BUFFER_TOP(curp->target) = target;
@@ -88,26 +126,179 @@ void gadd(unsigned char *name, unsigned char **target,
         EXPAND_BUFFER(curp->psl);
 
     STEP_BUFFER(curp->psl, 1);
-    BUFFER_TOP(curp->psl) = prepslbuf;
+    BUFFER_TOP(curp->psl) = newAction(prepsllen, prepsl);
 
     STEP_BUFFER(curp->psl, 1);
-    BUFFER_TOP(curp->psl) = postpslbuf;
+    BUFFER_TOP(curp->psl) = newAction(postpsllen, postpsl);
 }
 
 void grem(unsigned char *name)
 {
-    struct UProduction *curp = getUProduction(name);
+    struct UProduction *curp;
+
+    logGrammarInt(PRP_LOG_GREM);
+    logGrammarStr(strlen((char *) name), name);
+
+    productionMode(&name);
+    curp = getUProduction(name);
 
     INIT_BUFFER(curp->target);
     INIT_BUFFER(curp->psl);
+    curp->mode = PACKRAT_MODE_ALL;
 }
 
 void gcommit()
 {
+    /* the log is now just what makes this grammar */
+    if (grammarLog.buf == NULL)
+        INIT_ATOMIC_BUFFER(grammarLog);
+    grammarLog.bufused = 0;
+    logGrammarRecurse(new_grammar);
+    logGrammarInt(PRP_LOG_GCOMMIT);
+    grammarGeneration++;
+
     delAllProductions();
     gcommitRecurse(new_grammar);
 }
 
+static void logGrammarInt(size_t val)
+{
+    size_t len = pslBignumLength(val);
+    if (grammarLog.buf == NULL)
+        INIT_ATOMIC_BUFFER(grammarLog);
+    while (BUFFER_SPACE(grammarLog) < len)
+        EXPAND_BUFFER(grammarLog);
+    pslIntToBignum(BUFFER_END(grammarLog), val, len);
+    STEP_BUFFER(grammarLog, len);
+}
+
+static void logGrammarStr(size_t len, unsigned char *str)
+{
+    logGrammarInt(len);
+    WRITE_BUFFER(grammarLog, str, len);
+}
+
+/* log the gadds which make up these productions, the first of each marked
+ * with the production's mode */
+static void logGrammarRecurse(struct UProduction *curp)
+{
+    struct PlofRawData *pre, *post;
+    unsigned char *name;
+    size_t i, j;
+
+    if (curp == NULL) return;
+    logGrammarRecurse(curp->left);
+
+    for (i = 0; i < curp->target.bufused; i++) {
+        logGrammarInt(PRP_LOG_GADD);
+        if (i == 0 && curp->mode != PACKRAT_MODE_ALL) {
+            name = (unsigned char *) GC_MALLOC_ATOMIC(strlen((char *) curp->name) + 2);
+            name[0] = (curp->mode == PACKRAT_MODE_ORDERED) ? PRP_ORDERED_MARKER :
+                                                              PRP_LONGEST_MARKER;
+            strcpy((char *) name + 1, (char *) curp->name);
+        } else {
+            name = curp->name;
+        }
+        logGrammarStr(strlen((char *) name), name);
+
+        for (j = 0; curp->target.buf[i][j]; j++);
+        logGrammarInt(j);
+        for (j = 0; curp->target.buf[i][j]; j++)
+            logGrammarStr(strlen((char *) curp->target.buf[i][j]), curp->target.buf[i][j]);
+
+        pre = (struct PlofRawData *) curp->psl.buf[i*2]->data;
+        post = (struct PlofRawData *) curp->psl.buf[i*2+1]->data;
+        logGrammarStr(pre->length, pre->data);
+        logGrammarStr(post->length, post->data);
+    }
+
+    logGrammarRecurse(curp->right);
+}
+
+/* read a string from a grammar log into a new NUL-terminated copy */
+static unsigned char *replayGrammarStr(unsigned char *log, size_t *i, size_t *len)
+{
+    unsigned char *ret;
+    *i += pslBignumToInt(log + *i, len);
+    ret = (unsigned char *) GC_MALLOC_ATOMIC(*len + 1);
+    memcpy(ret, log + *i, *len);
+    ret[*len] = '\0';
+    *i += *len;
+    return ret;
+}
+
+struct Buffer_psl prpGrammarLog()
+{
+    if (grammarLog.buf == NULL)
+        INIT_ATOMIC_BUFFER(grammarLog);
+    return grammarLog;
+}
+
+size_t prpGrammarGeneration()
+{
+    return grammarGeneration;
+}
+
+/* redo the operation at log[*i], or if replay is 0 just step over it.
+ * Commits aren't redone, the caller does that. Returns the operation, or -1
+ * if it's bad */
+static int replayGrammarOp(unsigned char *log, size_t *i, int replay)
+{
+    size_t op, count, j, prelen, postlen, slen;
+    unsigned char *name, **target, *prepsl, *postpsl;
+
+    *i += pslBignumToInt(log + *i, &op);
+    switch (op) {
+        case PRP_LOG_GADD:
+            name = replayGrammarStr(log, i, &slen);
+            *i += pslBignumToInt(log + *i, &count);
+            target = (unsigned char **) GC_MALLOC((count + 1) * sizeof(unsigned char *));
+            for (j = 0; j < count; j++)
+                target[j] = replayGrammarStr(log, i, &slen);
+            target[j] = NULL;
+            prepsl = replayGrammarStr(log, i, &prelen);
+            postpsl = replayGrammarStr(log, i, &postlen);
+            if (replay) gadd(name, target, prelen, prepsl, postlen, postpsl);
+            break;
+
+        case PRP_LOG_GREM:
+            name = replayGrammarStr(log, i, &slen);
+            if (replay) grem(name);
+            break;
+
+        case PRP_LOG_GCOMMIT:
+            break;
+
+        default:
+            fprintf(stderr, "Bad grammar log!\n");
+            return -1;
+    }
+
+    return (int) op;
+}
+
+void prpReplayGrammar(size_t len, unsigned char *log)
+{
+    size_t i, committed;
+    int op;
+
+    /* find the end of the last commit */
+    committed = 0;
+    for (i = 0; i < len;) {
+        op = replayGrammarOp(log, &i, 0);
+        if (op < 0) return;
+        if (op == PRP_LOG_GCOMMIT) committed = i;
+    }
+
+    /* the grammar only needs building once, for what was committed, then
+     * whatever came after is left uncommitted as it was */
+    for (i = 0; i < committed;)
+        replayGrammarOp(log, &i, 1);
+    if (committed) gcommit();
+    for (i = committed; i < len;)
+        replayGrammarOp(log, &i, 1);
+}
+
 struct PRPResult parseOne(unsigned char *code, unsigned char *top, unsigned char *file,
                           unsigned int line, unsigned int column)
 {
@@ -136,7 +327,7 @@ struct PRPResult parseOne(unsigned char *code, unsigned char *top, unsigned char
 
     /* make sure it has raw data */
     if (pobj->data && pobj->data->type == PLOF_DATA_RAW) {
-        rd = (struct PlofRawData *) pobj->data;
+        rd = plofRawFlatten((struct PlofRawData *) pobj->data);
         ret.code.buf = rd->data;
         ret.code.bufused = ret.code.bufsz = rd->length;
     }
@@ -192,6 +383,14 @@ struct Buffer_psl parseAll(unsigned char *code, unsigned char *top, unsigned cha
     return res;
 }
 
+/* account for the time taken by a semantic action in the parse profile */
+static void profileAction(struct Production *production, double start)
+{
+    struct PackratProfile *prof = packratGetProfile(production);
+    prof->actions++;
+    prof->actionTime += packratProfileClock() - start;
+}
+
 struct PlofObject *parseHelper(unsigned char *code, struct ParseResult *pr, struct PlofObject *pctx)
 {
     int i;
@@ -199,19 +398,22 @@ struct PlofObject *parseHelper(unsigned char *code, struct ParseResult *pr, stru
     struct PlofArrayData *ad;
     struct PlofObject *ctx, *obj, *ret;
     size_t len;
+    double start = 0;
 
     /* run the precode if applicable */
     if (pr->production->userarg) {
         /* the code is stored as an array, needs to know which was chosen */
-        struct Buffer_psl psl = ((struct Buffer_psl *) pr->production->userarg)[pr->choice*2];
+        struct PlofObject *psl = ((struct PlofObject **) pr->production->userarg)[pr->choice*2];
 
         /* make the context */
         ctx = newPlofObject();
         ctx->parent = pctx;
         
         /* run it */
-        interpretPSL(ctx, plofNull, NULL, psl.bufused, psl.buf, 0, 0);
+        if (packratProfile) start = packratProfileClock();
+        interpretPSL(ctx, plofNull, psl, 0, NULL, 0, 0);
         /* FIXME: what if it throws? */
+        if (packratProfile) profileAction(pr->production, start);
 
     } else {
         ctx = plofNull; /* for -Wall */
@@ -232,10 +434,12 @@ struct PlofObject *parseHelper(unsigned char *code, struct ParseResult *pr, stru
         struct PlofReturn pret;
 
         /* the code is stored as an array, needs to know which was chosen */
-        struct Buffer_psl psl = ((struct Buffer_psl *) pr->production->userarg)[pr->choice*2+1];
+        struct PlofObject *psl = ((struct PlofObject **) pr->production->userarg)[pr->choice*2+1];
         
         /* run it */
-        pret = interpretPSL(ctx, obj, NULL, psl.bufused, psl.buf, 0, 0);
+        if (packratProfile) start = packratProfileClock();
+        pret = interpretPSL(ctx, obj, psl, 0, NULL, 0, 0);
+        if (packratProfile) profileAction(pr->production, start);
         if (pret.isThrown) {
             /* uh oh ! */
             ret = plofNull;
@@ -280,7 +484,7 @@ struct PlofObject *parseHelper(unsigned char *code, struct ParseResult *pr, stru
             ret->data &&
             ret->data->type == PLOF_DATA_RAW &&
             ((struct PlofRawData *) ret->data)->length > sizeof(size_t)) {
-            struct PlofRawData *rd = (struct PlofRawData *) ret->data;
+            struct PlofRawData *rd = plofRawFlatten((struct PlofRawData *) ret->data);
             struct Buffer_psl psl;
             size_t bignumsz, filenmsz;
             struct PlofObject *obj;
@@ -364,6 +568,23 @@ static struct UProduction *getUProduction(unsigned char *name)
     }
 }    
 
+/* get the mode marked on a production name, and skip the marker */
+static int productionMode(unsigned char **name)
+{
+    switch (**name) {
+        case PRP_ORDERED_MARKER:
+            (*name)++;
+            return PACKRAT_MODE_ORDERED;
+
+        case PRP_LONGEST_MARKER:
+            (*name)++;
+            return PACKRAT_MODE_LONGEST;
+
+        default:
+            return PACKRAT_MODE_ALL;
+    }
+}
+
 static struct UProduction *newUProduction(unsigned char *name)
 {
     struct UProduction *ret = NULL;
@@ -376,8 +597,19 @@ static struct UProduction *newUProduction(unsigned char *name)
     return ret;
 }
 
+/* wrap the PSL for an action in a procedure object, so its compiled form can
+ * be kept with it */
+static struct PlofObject *newAction(size_t psllen, unsigned char *psl)
+{
+    struct PlofObject *ret = newPlofObjectWithRaw(psllen);
+    ret->parent = plofNull;
+    memcpy(((struct PlofRawData *) ret->data)->data, psl, psllen);
+    return ret;
+}
+
 static void gcommitRecurse(struct UProduction *curp)
 {
+    struct Production *np;
     int i, j;
 
     for (i = 0; curp->target.buf[i]; i++) {
@@ -403,8 +635,9 @@ static void gcommitRecurse(struct UProduction *curp)
         }
     }
 
-    newPackratNonterminal(curp->name, curp->target.buf)->userarg
-        = curp->psl.buf;
+    np = newPackratNonterminal(curp->name, curp->target.buf);
+    np->userarg = curp->psl.buf;
+    np->mode = curp->mode;
 
     if (curp->left)
         gcommitRecurse(curp->left);
@@ -39,6 +39,19 @@
 #include "impl/local.c"
 #include "impl/localset.c"
 #include "impl/nullarray.c"
+#include "impl/tarray.c"
+#include "impl/tindex.c"
+#include "impl/tindexset.c"
+#include "impl/tfill.c"
+#include "impl/tcopy.c"
+#include "impl/tarith.c"
+#include "impl/treduce.c"
+#include "impl/traw.c"
+#include "impl/map.c"
+#include "impl/mapget.c"
+#include "impl/mapset.c"
+#include "impl/mapdel.c"
+#include "impl/mapkeys.c"
 #include "impl/rawlength.c"
 #include "impl/slice.c"
 #include "impl/rawcmp.c"
@@ -87,6 +100,7 @@
 #include "impl/print.c"
 #include "impl/debug.c"
 #include "impl/intrinsic.c"
+#include "impl/includeclear.c"
 #include "impl/trap.c"
 #include "impl/include.c"
 #include "impl/parse.c"
@@ -155,6 +155,58 @@ case psl_nullarray:
     FOREACH(nullarray);
 #include "optim/nullarray.c"
     break;
+case psl_tarray:
+    FOREACH(tarray);
+#include "optim/tarray.c"
+    break;
+case psl_tindex:
+    FOREACH(tindex);
+#include "optim/tindex.c"
+    break;
+case psl_tindexset:
+    FOREACH(tindexset);
+#include "optim/tindexset.c"
+    break;
+case psl_tfill:
+    FOREACH(tfill);
+#include "optim/tfill.c"
+    break;
+case psl_tcopy:
+    FOREACH(tcopy);
+#include "optim/tcopy.c"
+    break;
+case psl_tarith:
+    FOREACH(tarith);
+#include "optim/tarith.c"
+    break;
+case psl_treduce:
+    FOREACH(treduce);
+#include "optim/treduce.c"
+    break;
+case psl_traw:
+    FOREACH(traw);
+#include "optim/traw.c"
+    break;
+case psl_map:
+    FOREACH(map);
+#include "optim/map.c"
+    break;
+case psl_mapget:
+    FOREACH(mapget);
+#include "optim/mapget.c"
+    break;
+case psl_mapset:
+    FOREACH(mapset);
+#include "optim/mapset.c"
+    break;
+case psl_mapdel:
+    FOREACH(mapdel);
+#include "optim/mapdel.c"
+    break;
+case psl_mapkeys:
+    FOREACH(mapkeys);
+#include "optim/mapkeys.c"
+    break;
 case psl_rawlength:
     FOREACH(rawlength);
 #include "optim/rawlength.c"
@@ -347,6 +399,10 @@ case psl_intrinsic:
     FOREACH(intrinsic);
 #include "optim/intrinsic.c"
     break;
+case psl_includeclear:
+    FOREACH(includeclear);
+#include "optim/includeclear.c"
+    break;
 case psl_trap:
     FOREACH(trap);
 #include "optim/trap.c"
@@ -26,6 +26,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #ifdef HAVE_CONFIG_H
 #include "../config.h"
@@ -33,10 +34,6 @@
 #include "basicconfig.h"
 #endif
 
-#if defined(DEBUG_TIMING) || defined(DEBUG_TIMING_PROCEDURE)
-#include <time.h>
-#endif
-
 /* For CNFI */
 #ifdef WITH_CNFI
 #include <dlfcn.h>
@@ -54,10 +51,12 @@ typedef struct _ffi_cif_plus {
 
 /* For predefs */
 #ifdef HAVE_UNISTD_H
+#include <sys/stat.h>
 #include <unistd.h>
 #endif
 
 #include "plof/bignum.h"
+#include "plof/bundle.h"
 #include "impl.h"
 #include "interp.h"
 #include "intrinsics.h"
@@ -66,6 +65,7 @@ typedef struct _ffi_cif_plus {
 #include "plof/memory.h"
 #include "optimizations.h"
 #include "plof/plof.h"
+#include "plof/profile.h"
 #include "plof/prp.h"
 #include "plof/psl.h"
 #include "plof/pslfile.h"
@@ -94,6 +94,9 @@ FILE *debug_instruction_sequence_fh = NULL;
 enum jumplabel {
 #define FOREACH(inst) interp_psl_ ## inst,
 #include "psl_internal_inst.h"
+#undef FOREACH
+#define FOREACH(inst) interp_count_psl_ ## inst,
+#include "psl_internal_inst.h"
 #undef FOREACH
 
     interp_psl_last
@@ -103,10 +106,71 @@ enum jumplabel {
 /* Implementation of 'replace' */
 struct PlofRawData *pslReplace(struct PlofRawData *in, struct PlofArrayData *with);
 
+#ifndef PLOF_NO_PARSER
+/* The parsed form of an included file, if it's been parsed with this start
+ * production, file name and grammar, else NULL */
+static struct PlofRawData *plofIncludeParsedGet(struct PlofRawData *rd, struct PlofRawData *top,
+                                                struct PlofRawData *file);
+static void plofIncludeParsedPut(struct PlofRawData *rd, struct PlofRawData *top,
+                                 struct PlofRawData *file, struct PlofRawData *parsed);
+#endif
+
+/* Anonymous PSL (pslalt to interpretPSL) has nowhere to keep its compiled
+ * form, so it's cached here, keyed by content. The cache is direct-mapped, so
+ * a collision simply replaces the old entry */
+#ifndef PSL_ALT_CACHE_BITS
+#define PSL_ALT_CACHE_BITS 8
+#endif
+#define PSL_ALT_CACHE_SIZE (1<<PSL_ALT_CACHE_BITS)
+#define PSL_ALT_CACHE_MASK (PSL_ALT_CACHE_SIZE - 1)
+struct PSLAltCacheEntry {
+    size_t hash;
+    size_t psllen;
+    unsigned char *psl;
+    int immediate;
+    void **cpslargs;
+};
+static struct PSLAltCacheEntry *pslAltCache = NULL;
+
+/* Look for anonymous PSL in the cache, returning its cpslargs or NULL */
+static void **pslAltCacheGet(size_t hash, size_t psllen, unsigned char *psl, int immediate)
+{
+    struct PSLAltCacheEntry *ce;
+
+    if (!pslAltCache) return NULL;
+
+    ce = pslAltCache + ((hash ^ immediate) & PSL_ALT_CACHE_MASK);
+    if (ce->cpslargs && ce->hash == hash && ce->psllen == psllen &&
+        ce->immediate == immediate &&
+        (ce->psl == psl || !memcmp(ce->psl, psl, psllen))) {
+        return ce->cpslargs;
+    }
+
+    return NULL;
+}
+
+/* Remember the compiled form of anonymous PSL */
+static void pslAltCachePut(size_t hash, size_t psllen, unsigned char *psl, int immediate, void **cpslargs)
+{
+    struct PSLAltCacheEntry *ce;
+
+    if (!pslAltCache) {
+        pslAltCache = GC_MALLOC(PSL_ALT_CACHE_SIZE * sizeof(struct PSLAltCacheEntry));
+    }
+
+    ce = pslAltCache + ((hash ^ immediate) & PSL_ALT_CACHE_MASK);
+    ce->hash = hash;
+    ce->psllen = psllen;
+    ce->psl = psl;
+    ce->immediate = immediate;
+    ce->cpslargs = cpslargs;
+}
+
 /* Compile PSL into a series of jumps */
 struct PlofReturn compilePSL(
     size_t psllen,      /* the PSL itself */
     unsigned char *psl,
+    struct PlofRawData *pslrd, /* the raw data psl is in, if any */
     int immediate,      /* compile only immediates */
     size_t *cpslalenp,  /* if providing your own args array, current length and point */
     size_t *cpslaip,
@@ -170,12 +234,10 @@ struct PlofReturn compilePSL(
 
             /* make sure this doesn't go off the edge */
             if (psli + len > psllen) {
-                rd = newPlofRawData(128);
-                sprintf((char *) rd->data, "Bad data in PSL, instruction of type %X too long ((%d+%d)/%d)",
-                        (int) cmd, (int) psli, (int) len, (int) psllen);
-                a = newPlofObject();
+                a = newPlofObjectWithRaw(128);
                 a->parent = plofNull;
-                a->data = (struct PlofData *) rd;
+                sprintf((char *) RAW(a)->data, "Bad data in PSL, instruction of type %X too long ((%d+%d)/%d)",
+                        (int) cmd, (int) psli, (int) len, (int) psllen);
 
                 ret.ret = newPlofObject();
                 ret.ret->parent = plofNull;
@@ -184,9 +246,13 @@ struct PlofReturn compilePSL(
                 return ret;
             }
 
-            /* copy it in */
-            raw = newPlofRawData(len);
-            memcpy(raw->data, psl + psli, len);
+            /* view it if we can, or copy it in */
+            if (pslrd) {
+                raw = plofRawSlice(pslrd, psli, len);
+            } else {
+                raw = newPlofRawData(len);
+                memcpy(raw->data, psl + psli, len);
+            }
             psli += len - 1;
 
             if (cpslai >= cpslalen) {
@@ -394,7 +460,7 @@ struct PlofReturn interpretPSL(
     struct PlofObject **locals;
 
     /* The PSL in various forms */
-    size_t psllen;
+    size_t psllen, pslhash = 0;
     unsigned char *psl = NULL;
     void **cpsl = NULL;
     void **cpslargs = NULL;
@@ -410,6 +476,9 @@ struct PlofReturn interpretPSL(
     unsigned char *dfile = NULL;
     ptrdiff_t dline = -1, dcol = -1;
 
+    /* for the profiler */
+    volatile struct PlofProfileFrame profileFrame;
+
     /* timing info */
 #ifdef DEBUG_TIMING
     char *tiName;
@@ -429,6 +498,24 @@ struct PlofReturn interpretPSL(
                 default: pslCompileLabels[i] = NULL; break;
             }
         }
+
+        /* when counting, compile to instructions which count, then run the
+         * real ones */
+        if (plofCountOps) {
+            plofOpCounts = (unsigned long *) GC_MALLOC_ATOMIC(label_psl_last * sizeof(unsigned long));
+            memset(plofOpCounts, 0, label_psl_last * sizeof(unsigned long));
+            plofOpPairCounts = (unsigned long (*)[label_psl_last])
+                GC_MALLOC_ATOMIC(label_psl_last * sizeof(*plofOpPairCounts));
+            memset(plofOpPairCounts, 0, label_psl_last * sizeof(*plofOpPairCounts));
+
+            for (i = 0; i < label_psl_last; i++) {
+                switch (i) {
+#define FOREACH(inst) case label_psl_ ## inst: pslCompileLabels[i] = addressof(interp_count_psl_ ## inst); break;
+#include "psl_internal_inst.h"
+#undef FOREACH
+                }
+            }
+        }
         setupCompileLabels = 1;
     }
 
@@ -440,7 +527,7 @@ struct PlofReturn interpretPSL(
 
     /* Get out the PSL */
     if (pslraw) {
-        rd = (struct PlofRawData *) pslraw->data;
+        rd = RAW(pslraw);
         psllen = rd->length;
         psl = rd->data;
         cpslargs = rd->idata;
@@ -450,9 +537,13 @@ struct PlofReturn interpretPSL(
         psl = pslalt;
     }
 
+    PLOF_PROFILE_ENTER(profileFrame, rd, &dfile, &dline);
+    if (plofCountOps) plofCountCall(rd);
+
     /* call the intrinsic if applicable */
     if (pslraw && rd->proc) {
         ret = rd->proc(context, arg);
+        PLOF_PROFILE_LEAVE(profileFrame);
 #ifdef DEBUG_TIMING_PROCEDURE
         clock_gettime(CLOCK_MONOTONIC, &petspec);
 #ifdef DEBUG_NAMES
@@ -473,6 +564,7 @@ struct PlofReturn interpretPSL(
         ret.ret = plofNull;
         if (arg) ret.ret = arg;
         ret.isThrown = 0;
+        PLOF_PROFILE_LEAVE(profileFrame);
         return ret;
     }
 
@@ -497,8 +589,8 @@ struct PlofReturn interpretPSL(
         locals = LOCALS(context)->data;
     }
 
-    /* add +procedure */
-    if (pslraw) {
+    /* add +procedure (only to contexts of our own, as others belong to the caller) */
+    if (pslraw && generateContext) {
         if (procedureHash == 0) {
             procedureHash = plofHash(10, (unsigned char *) "+procedure");
         }
@@ -506,18 +598,26 @@ struct PlofReturn interpretPSL(
     }
 
     /* Make sure it's compiled */
+    if (!cpslargs && !pslraw) {
+        pslhash = plofHash(psllen, psl);
+        cpslargs = pslAltCacheGet(pslhash, psllen, psl, immediate);
+    }
     if (cpslargs) {
         cpsl = (void **) cpslargs[0];
 
     } else {
         size_t cpsllen;
-        ret = compilePSL(psllen, psl, immediate, NULL, NULL, NULL, &cpsllen, &cpslargs);
+        ret = compilePSL(psllen, psl, rd, immediate, NULL, NULL, NULL, &cpsllen, &cpslargs);
         if (ret.isThrown) goto performThrow;
         cpsl = (void **) cpslargs[0];
 
         /* and save it */
-        if (pslraw && !immediate) {
-            ((struct PlofRawData *) pslraw->data)->idata = cpslargs;
+        if (pslraw) {
+            if (!immediate) {
+                ((struct PlofRawData *) pslraw->data)->idata = cpslargs;
+            }
+        } else {
+            pslAltCachePut(pslhash, psllen, psl, immediate, cpslargs);
         }
     }
 
@@ -536,6 +636,17 @@ struct PlofReturn interpretPSL(
 
     jumphead;
 #include "psl-impl.c"
+
+    /* counting instructions (see plofCountOps) */
+#define FOREACH(inst) \
+label(interp_count_psl_ ## inst); \
+    plofOpCounts[label_psl_ ## inst]++; \
+    plofOpPairCounts[plofOpLast][label_psl_ ## inst]++; \
+    plofOpLast = label_psl_ ## inst; \
+    jump(addressof(interp_psl_ ## inst));
+#include "psl_internal_inst.h"
+#undef FOREACH
+
 label(interp_psl_last);
     jumptail;
 
@@ -554,17 +665,17 @@ performThrow:
             curmsg = rd->data;
         }
 
-        rd = newPlofRawData(curlen + strlen((char *) dfile) + 6*sizeof(int) + 16);
+        a = newPlofObjectWithRaw(curlen + strlen((char *) dfile) + 6*sizeof(int) + 16);
+        a->parent = plofNull;
+        rd = RAW(a);
         sprintf((char *) rd->data, "%.*s\n\tat %s line %d col %d", (int) curlen, curmsg, dfile, (int) dline+1, (int) dcol+1);
         rd->length = strlen((char *) rd->data);
-        a = newPlofObject();
-        a->parent = plofNull;
-        a->data = (struct PlofData *) rd;
 
         plofWrite(ret.ret, (unsigned char *) PSL_EXCEPTION_STACK, es, a);
     }
 
 opRet:
+    PLOF_PROFILE_LEAVE(profileFrame);
     return ret;
 }
 
@@ -616,16 +727,8 @@ struct PlofObject *plofCombine(struct PlofObject *a, struct PlofObject *b)
     /* now get any data */
     if (ISRAW(a)) {
         if (ISRAW(b)) {
-            struct PlofRawData *ra, *rb;
-            ra = RAW(a);
-            rb = RAW(b);
-
-            rd = newPlofRawData(ra->length + rb->length);
-
-            /* copy in both */
-            memcpy(rd->data, ra->data, ra->length);
-            memcpy(rd->data + ra->length, rb->data, rb->length);
-
+            /* concatenate them */
+            rd = plofRawConcat(RAWROPE(a), RAWROPE(b));
             newo->data = (struct PlofData *) rd;
 
         } else {
@@ -681,98 +784,274 @@ struct PlofObject *plofCombine(struct PlofObject *a, struct PlofObject *b)
     return newo;
 }
 
-/* Copy the content of a PlofOHashTable into an object */
-void plofObjCopyPrime(struct PlofObject *to, struct PlofOHashTable *from)
+/* Copy an object's whole hash table into an object which doesn't yet have
+ * one. This is a structural copy, so it needs no lookups, and all the chained
+ * entries are allocated together */
+static void plofObjCloneTable(struct PlofObject *to, struct PlofOHashTables *from)
 {
-    if (from == NULL || from->name == NULL) return;
+    struct PlofOHashTables *ht;
+    struct PlofOHashTable *cur, *into, *chained;
+    size_t count;
+    int i;
+
+    /* count the chained entries */
+    count = 0;
+    for (i = 0; i < PLOF_HASHTABLE_SIZE; i++) {
+        if (from->elems[i].name == NULL) continue;
+        for (cur = from->elems[i].next; cur; cur = cur->next) count++;
+    }
+
+    ht = GC_NEW(struct PlofOHashTables);
+    chained = NULL;
+    if (count)
+        chained = (struct PlofOHashTable *) GC_MALLOC(count * sizeof(struct PlofOHashTable));
+
+    /* then copy them, preserving order */
+    for (i = 0; i < PLOF_HASHTABLE_SIZE; i++) {
+        if (from->elems[i].name == NULL) continue;
+        into = &ht->elems[i];
+        *into = from->elems[i];
+        for (cur = from->elems[i].next; cur; cur = cur->next) {
+            into->next = chained;
+            into = chained++;
+            *into = *cur;
+        }
+        into->next = NULL;
+    }
 
-    plofWrite(to, from->name, from->hashedName, from->value);
-    plofObjCopyPrime(to, from->next);
+    to->hashTable = ht;
 }
 
 /* Copy the content of one object into another */
 void plofObjCopy(struct PlofObject *to, struct PlofObject *from)
 {
+    struct PlofOHashTable *cur;
     int i;
 
-    if (from->hashTable) {
-        struct PlofOHashTables *ht = from->hashTable;
-        for (i = 0; i < PLOF_HASHTABLE_SIZE; i++) {
-            plofObjCopyPrime(to, &ht->elems[i]);
-        }
+    if (!from->hashTable) return;
+
+    /* the common case of copying into a fresh object is a bulk copy */
+    if (!to->hashTable) {
+        plofObjCloneTable(to, from->hashTable);
+        return;
     }
-}
 
+    /* otherwise merge them in */
+    for (i = 0; i < PLOF_HASHTABLE_SIZE; i++) {
+        for (cur = &from->hashTable->elems[i]; cur && cur->name; cur = cur->next)
+            plofWrite(to, cur->name, cur->hashedName, cur->value);
+    }
+}
 
-struct PlofObjects {
-    size_t length;
-    struct PlofObject **data;
-};
 
-/* Internal function used by plofMembers */
-struct PlofObjects plofMembersSub(struct PlofOHashTable *of)
+/* Make the name object for a member name handed out by 'members'. It's a view
+ * of the member's own name, so enumerating an object copies no names and their
+ * hashes are precomputed; writing to it unshares it first like any view */
+struct PlofObject *plofMemberName(unsigned char *name, size_t namehash)
 {
-    struct PlofObjects next, ret;
     struct PlofObject *obj;
     struct PlofRawData *rd;
 
-    if (of == NULL || of->name == NULL) {
-        ret.length = 0;
-        ret.data = NULL;
-        return ret;
+    rd = newPlofRawDataView(strlen((char *) name), name);
+    rd->hash = namehash;
+    obj = newPlofObject();
+    obj->parent = plofNull;
+    obj->data = (struct PlofData *) rd;
+
+    return obj;
+}
+
+/* Maps hash keys with a per-process random seed as the starting state, so
+ * that which keys collide differs from run to run. It's a cheap mix, not a
+ * keyed cryptographic hash */
+static size_t plofMapSeed = 0;
+
+/* the golden ratio multiplier for mixing map hashes, 0x9E3779B97F4A7C15 where
+ * size_t is 64 bits and its low half elsewhere (built from halves, since C90
+ * has no long long constants) */
+#define PLOF_MAP_MIX ((((size_t) 0x9E3779B9UL << 16) << 16) | (size_t) 0x7F4A7C15UL)
+
+/* pick the map seed, from /dev/urandom if there is one */
+static void plofMapSeedInit()
+{
+    FILE *fh;
+    size_t seed = 0;
+
+    fh = fopen("/dev/urandom", "rb");
+    if (fh != NULL) {
+        if (fread(&seed, sizeof(size_t), 1, fh) != 1) seed = 0;
+        fclose(fh);
     }
 
-    /* get the left and right members */
-    next = plofMembersSub(of->next);
+    if (seed == 0) {
+        /* otherwise whatever varies from run to run */
+        seed = (size_t) time(NULL) * PLOF_MAP_MIX;
+#ifdef HAVE_UNISTD_H
+        seed ^= (size_t) getpid();
+#endif
+        seed ^= (size_t) &seed;
+    }
 
-    /* prepare ours */
-    ret.length = next.length + 1;
-    ret.data = (struct PlofObject **) GC_MALLOC(ret.length * sizeof(struct PlofObject *));
+    plofMapSeed = seed | 1;
+}
 
-    /* and the object */
-    rd = newPlofRawData(strlen((char *) of->name));
-    memcpy(rd->data, of->name, rd->length);
-    obj = newPlofObject();
-    obj->parent = plofNull; /* FIXME */
-    obj->data = (struct PlofData *) rd;
+/* hash a map key. Raw keys are hashed byte by byte from the seed (not from
+ * their cached hash), so keys which collide for one seed needn't for another */
+static size_t plofMapHash(struct PlofObject *key)
+{
+    size_t hash, i;
+    struct PlofRawData *rd;
 
-    /* then copy */
-    ret.data[0] = obj;
-    memcpy(ret.data + 1, next.data, next.length * sizeof(struct PlofObject *));
+    if (plofMapSeed == 0) plofMapSeedInit();
 
-    /* FIXME: this is all horrendously inefficient for a list, but then again these lists are meant to be quite short */
+    hash = plofMapSeed;
+    if (ISINT(key)) {
+        hash ^= (size_t) ASINT(key);
+        hash *= PLOF_MAP_MIX;
+    } else {
+        rd = RAW(key);
+        for (i = 0; i < rd->length; i++) {
+            hash = (hash ^ rd->data[i]) * PLOF_MAP_MIX;
+            hash ^= hash >> (sizeof(size_t) * 4);
+        }
+        hash ^= rd->length;
+        hash *= PLOF_MAP_MIX;
+    }
 
-    return ret;
+    /* spread the bits, since the table is masked */
+    hash ^= hash >> (sizeof(size_t) * 4);
+    return hash;
+}
+
+/* are these keys the same? */
+static int plofMapKeyEq(struct PlofObject *a, struct PlofObject *b)
+{
+    struct PlofRawData *ra, *rb;
+    if (a == b) return 1;
+    if (ISINT(a) || ISINT(b)) return 0;
+    ra = RAW(a);
+    rb = RAW(b);
+    return ra->length == rb->length && !memcmp(ra->data, rb->data, ra->length);
+}
+
+/* find the slot for key, either where it is or the empty slot it would go in */
+static struct PlofMapSlot *plofMapFind(struct PlofMapData *md, struct PlofObject *key, size_t hash)
+{
+    size_t mask = md->capacity - 1;
+    size_t i = hash & mask;
+    struct PlofMapSlot *slot;
+
+    for (;; i = (i + 1) & mask) {
+        slot = md->slots + i;
+        if (!slot->key ||
+            (slot->hash == hash && plofMapKeyEq(slot->key, key)))
+            return slot;
+    }
+}
+
+/* Get a value from a map */
+struct PlofObject *plofMapGet(struct PlofMapData *md, struct PlofObject *key)
+{
+    struct PlofMapSlot *slot = plofMapFind(md, key, plofMapHash(key));
+    return slot->key ? slot->value : NULL;
+}
+
+/* Put a value in a map */
+void plofMapPut(struct PlofMapData *md, struct PlofObject *key, struct PlofObject *value)
+{
+    size_t hash = plofMapHash(key);
+    struct PlofMapSlot *slot = plofMapFind(md, key, hash);
+
+    if (slot->key) {
+        slot->value = value;
+        return;
+    }
+
+    /* keep the load factor under 3/4, so probe sequences stay short */
+    if ((md->length + 1) * 4 > md->capacity * 3) {
+        struct PlofMapSlot *old = md->slots;
+        size_t oldcap = md->capacity, i;
+
+        md->capacity *= 2;
+        md->slots = (struct PlofMapSlot *) GC_MALLOC(md->capacity * sizeof(struct PlofMapSlot));
+        for (i = 0; i < oldcap; i++) {
+            if (old[i].key)
+                *plofMapFind(md, old[i].key, old[i].hash) = old[i];
+        }
+
+        slot = plofMapFind(md, key, hash);
+    }
+
+    slot->hash = hash;
+    slot->key = key;
+    slot->value = value;
+    md->length++;
+}
+
+/* Remove a key from a map */
+int plofMapRemove(struct PlofMapData *md, struct PlofObject *key)
+{
+    size_t mask = md->capacity - 1;
+    struct PlofMapSlot *slot = plofMapFind(md, key, plofMapHash(key));
+    size_t i, j, home;
+
+    if (!slot->key) return 0;
+
+    /* there are no tombstones: instead, shift back any later entries in the
+     * run that would no longer be found past the hole */
+    i = slot - md->slots;
+    for (j = (i + 1) & mask; md->slots[j].key; j = (j + 1) & mask) {
+        home = md->slots[j].hash & mask;
+        if (((j - home) & mask) >= ((j - i) & mask)) {
+            md->slots[i] = md->slots[j];
+            i = j;
+        }
+    }
+    md->slots[i].key = md->slots[i].value = NULL;
+    md->length--;
+
+    return 1;
+}
+
+/* Make an array of the keys of a map */
+struct PlofArrayData *plofMapKeys(struct PlofMapData *md)
+{
+    struct PlofArrayData *ad;
+    size_t i, len = 0;
+
+    ad = newPlofArrayData(md->length);
+    for (i = 0; i < md->capacity; i++) {
+        if (md->slots[i].key)
+            ad->data[len++] = md->slots[i].key;
+    }
+
+    return ad;
 }
 
 /* Make an array of the list of members of an object */
 struct PlofArrayData *plofMembers(struct PlofObject *of)
 {
     struct PlofArrayData *ad;
-    int i, off;
-    struct PlofObjects eachobjs[PLOF_HASHTABLE_SIZE];
+    struct PlofOHashTable *cur;
     size_t len;
+    int i;
 
-    /* get out the members */
+    /* count them first, so the array is allocated once */
+    len = 0;
     if (of->hashTable) {
-        struct PlofOHashTables *ht = of->hashTable;
         for (i = 0; i < PLOF_HASHTABLE_SIZE; i++) {
-            eachobjs[i] = plofMembersSub(&ht->elems[i]);
+            for (cur = &of->hashTable->elems[i]; cur && cur->name; cur = cur->next)
+                len++;
         }
-    } else {
-        memset(eachobjs, 0, PLOF_HASHTABLE_SIZE * sizeof(struct PlofObjects));
     }
 
-    /* and combine them into the output */
-    len = 0;
-    for (i = 0; i < PLOF_HASHTABLE_SIZE; i++) len += eachobjs[i].length;
+    /* then fill it in */
     ad = newPlofArrayData(len);
-
-    off = 0;
-    for (i = 0; i < PLOF_HASHTABLE_SIZE; i++) {
-        if (eachobjs[i].length) {
-            memcpy(ad->data + off, eachobjs[i].data, eachobjs[i].length * sizeof(struct PlofObject *));
-            off += eachobjs[i].length;
+    len = 0;
+    if (of->hashTable) {
+        for (i = 0; i < PLOF_HASHTABLE_SIZE; i++) {
+            for (cur = &of->hashTable->elems[i]; cur && cur->name; cur = cur->next)
+                ad->data[len++] = plofMemberName(cur->name, cur->hashedName);
         }
     }
 
@@ -804,8 +1083,7 @@ struct PlofRawData *pslReplace(struct PlofRawData *in, struct PlofArrayData *wit
                 len = in->length - i;
             }
 
-            data = newPlofRawData(len);
-            memcpy(data->data, in->data + i, len);
+            data = plofRawSlice(in, i, len);
             i += len - 1;
         }
 
@@ -965,6 +1243,185 @@ void plofSetArgs(struct PlofObject *into, unsigned char *name, int argc, char **
     plofWrite(into, name, plofHash(strlen((char *) name), name), argarr);
 }
 
+/* The include cache: what each name include()d resolved to, so that a file
+ * included again isn't searched for or loaded again, and what it parsed to,
+ * so that it isn't parsed again unless the grammar has changed. Files are
+ * checked for modification when they're included again, and a file which
+ * wasn't found is looked for again. includeclear (plofIncludeCacheClear)
+ * forgets it all. Parses with immediates aren't kept, as those must run every
+ * time. Entries are found by name, and by their data for parse */
+#define PLOF_INCLUDE_CACHE_SIZE 64
+
+/* enough of a file's status to tell if it's been changed since */
+struct PlofIncludeStamp {
+    long mtime, mtimeNsec;
+    unsigned long size, inode;
+};
+
+struct PlofIncludeCache {
+    struct PlofIncludeCache *next, *nextByData;
+    size_t namelen;
+    unsigned char *name, *path;
+    struct PlofIncludeStamp stamp;
+    struct PlofRawData *rd;
+
+    /* the parsed form */
+    struct PlofRawData *parsed;
+    unsigned char *parsedTop, *parsedFile;
+    size_t parsedGeneration;
+};
+static struct PlofIncludeCache *includeCache[PLOF_INCLUDE_CACHE_SIZE];
+static struct PlofIncludeCache *includeCacheData[PLOF_INCLUDE_CACHE_SIZE];
+
+#define INCLUDE_DATA_BUCKET(rd) (((size_t) (rd) >> 4) % PLOF_INCLUDE_CACHE_SIZE)
+
+/* set what an entry's data is, keeping it in the right data bucket */
+static void includeSetData(struct PlofIncludeCache *ic, struct PlofRawData *rd)
+{
+    struct PlofIncludeCache **cur;
+
+    if (ic->rd) {
+        cur = &includeCacheData[INCLUDE_DATA_BUCKET(ic->rd)];
+        for (; *cur; cur = &(*cur)->nextByData) {
+            if (*cur == ic) {
+                *cur = ic->nextByData;
+                break;
+            }
+        }
+    }
+
+    ic->rd = rd;
+    ic->nextByData = NULL;
+    if (rd) {
+        ic->nextByData = includeCacheData[INCLUDE_DATA_BUCKET(rd)];
+        includeCacheData[INCLUDE_DATA_BUCKET(rd)] = ic;
+    }
+}
+
+/* get a file's stamp, returning 0 if it can't be found */
+static int includeStamp(FILE *fh, const char *path, struct PlofIncludeStamp *stamp)
+{
+    memset(stamp, 0, sizeof(struct PlofIncludeStamp));
+#ifdef HAVE_UNISTD_H
+    {
+        struct stat st;
+        if ((fh ? fstat(fileno(fh), &st) : stat(path, &st)) != 0) return 0;
+        stamp->mtime = (long) st.st_mtime;
+#ifdef HAVE_STRUCT_STAT_ST_MTIM
+        /* mtimes are only to the second, which a quick rewrite can beat */
+        stamp->mtimeNsec = (long) st.st_mtim.tv_nsec;
+#endif
+        stamp->size = (unsigned long) st.st_size;
+        stamp->inode = (unsigned long) st.st_ino;
+    }
+#endif
+    return 1;
+}
+
+/* has this file changed since it was included? */
+static int includeChanged(struct PlofIncludeCache *ic)
+{
+    struct PlofIncludeStamp now;
+    if (!includeStamp(NULL, (char *) ic->path, &now)) return 1;
+    return (now.mtime != ic->stamp.mtime || now.mtimeNsec != ic->stamp.mtimeNsec ||
+            now.size != ic->stamp.size || now.inode != ic->stamp.inode);
+}
+
+/* Find a file to include */
+struct PlofRawData *plofInclude(size_t namelen, unsigned char *name)
+{
+    struct PlofIncludeCache *ic;
+    unsigned char **path, *data;
+    size_t datasz, bucket;
+    char *file;
+    FILE *fh;
+
+    bucket = plofHash(namelen, name) % PLOF_INCLUDE_CACHE_SIZE;
+    for (ic = includeCache[bucket]; ic; ic = ic->next) {
+        if (ic->namelen == namelen && !memcmp(ic->name, name, namelen)) break;
+    }
+
+    if (ic) {
+        /* we know where it is, but it may have changed (and if it wasn't
+         * found, it may be there now) */
+        if (ic->rd && (!ic->path || !includeChanged(ic)))
+            return ic->rd;
+
+    } else {
+        ic = GC_NEW(struct PlofIncludeCache);
+        ic->namelen = namelen;
+        ic->name = (unsigned char *) GC_MALLOC_ATOMIC(namelen);
+        memcpy(ic->name, name, namelen);
+        ic->next = includeCache[bucket];
+        includeCache[bucket] = ic;
+
+    }
+    ic->path = NULL;
+    ic->parsed = NULL;
+
+    /* look for the file in the bundle, then in each path */
+    data = plofBundleFind(namelen, name, &datasz);
+    for (path = plofIncludePaths; !data && *path; path++) {
+        file = GC_MALLOC_ATOMIC(strlen((char *) *path) + namelen + 2);
+        sprintf(file, "%s/%.*s", (char *) *path, (int) namelen, (char *) name);
+
+        fh = fopen(file, "r");
+        if (fh != NULL) {
+            /* this file exists, use it */
+            ic->path = (unsigned char *) file;
+            includeStamp(fh, file, &ic->stamp);
+            data = pslLoadFile(fh, &datasz);
+            fclose(fh);
+        }
+    }
+
+    /* the file's data isn't copied, so the raw data is a view of it (or of
+     * the bundle) */
+    includeSetData(ic, data ? newPlofRawDataView(datasz, data) : NULL);
+
+    return ic->rd;
+}
+
+/* Forget everything include has found */
+void plofIncludeCacheClear()
+{
+    memset(includeCache, 0, sizeof(includeCache));
+    memset(includeCacheData, 0, sizeof(includeCacheData));
+}
+
+#ifndef PLOF_NO_PARSER
+static struct PlofIncludeCache *includeCacheByData(struct PlofRawData *rd)
+{
+    struct PlofIncludeCache *ic;
+    for (ic = includeCacheData[INCLUDE_DATA_BUCKET(rd)]; ic; ic = ic->nextByData) {
+        if (ic->rd == rd) return ic;
+    }
+    return NULL;
+}
+
+static struct PlofRawData *plofIncludeParsedGet(struct PlofRawData *rd, struct PlofRawData *top,
+                                                struct PlofRawData *file)
+{
+    struct PlofIncludeCache *ic = includeCacheByData(rd);
+    if (ic && ic->parsed && ic->parsedGeneration == prpGrammarGeneration() &&
+        !strcmp((char *) ic->parsedTop, (char *) top->data) &&
+        !strcmp((char *) ic->parsedFile, (char *) file->data))
+        return ic->parsed;
+    return NULL;
+}
+
+static void plofIncludeParsedPut(struct PlofRawData *rd, struct PlofRawData *top,
+                                 struct PlofRawData *file, struct PlofRawData *parsed)
+{
+    struct PlofIncludeCache *ic = includeCacheByData(rd);
+    if (ic == NULL || pslHasImmediate(parsed->length, parsed->data)) return;
+    ic->parsed = parsed;
+    ic->parsedTop = (unsigned char *) GC_STRDUP((char *) top->data);
+    ic->parsedFile = (unsigned char *) GC_STRDUP((char *) file->data);
+    ic->parsedGeneration = prpGrammarGeneration();
+}
+#endif
+
 /* GC on DJGPP is screwy */
 #ifdef __DJGPP__
 void vsnprintf() {}
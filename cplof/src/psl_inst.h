@@ -61,6 +61,19 @@ FOREACH(locals)
 FOREACH(local)
 FOREACH(localset)
 FOREACH(nullarray)
+FOREACH(tarray)
+FOREACH(tindex)
+FOREACH(tindexset)
+FOREACH(tfill)
+FOREACH(tcopy)
+FOREACH(tarith)
+FOREACH(treduce)
+FOREACH(traw)
+FOREACH(map)
+FOREACH(mapget)
+FOREACH(mapset)
+FOREACH(mapdel)
+FOREACH(mapkeys)
 FOREACH(rawlength)
 FOREACH(slice)
 FOREACH(rawcmp)
@@ -109,6 +122,7 @@ FOREACH(dinstruction_sequence_end)
 FOREACH(print)
 FOREACH(debug)
 FOREACH(intrinsic)
+FOREACH(includeclear)
 FOREACH(trap)
 FOREACH(include)
 FOREACH(parse)
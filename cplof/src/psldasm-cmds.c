@@ -116,6 +116,45 @@ break;
 case psl_nullarray:
 fprintf(out, "nullarray\n");
 break;
+case psl_tarray:
+fprintf(out, "tarray\n");
+break;
+case psl_tindex:
+fprintf(out, "tindex\n");
+break;
+case psl_tindexset:
+fprintf(out, "tindexset\n");
+break;
+case psl_tfill:
+fprintf(out, "tfill\n");
+break;
+case psl_tcopy:
+fprintf(out, "tcopy\n");
+break;
+case psl_tarith:
+fprintf(out, "tarith\n");
+break;
+case psl_treduce:
+fprintf(out, "treduce\n");
+break;
+case psl_traw:
+fprintf(out, "traw\n");
+break;
+case psl_map:
+fprintf(out, "map\n");
+break;
+case psl_mapget:
+fprintf(out, "mapget\n");
+break;
+case psl_mapset:
+fprintf(out, "mapset\n");
+break;
+case psl_mapdel:
+fprintf(out, "mapdel\n");
+break;
+case psl_mapkeys:
+fprintf(out, "mapkeys\n");
+break;
 case psl_rawlength:
 fprintf(out, "rawlength\n");
 break;
@@ -260,6 +299,9 @@ break;
 case psl_intrinsic:
 fprintf(out, "intrinsic\n");
 break;
+case psl_includeclear:
+fprintf(out, "includeclear\n");
+break;
 case psl_trap:
 fprintf(out, "trap\n");
 break;
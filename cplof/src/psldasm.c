@@ -56,9 +56,8 @@ int main(int argc, char **argv)
         return 1;
     }
 
-    /* read in the buffer */
-    INIT_ATOMIC_BUFFER(psl);
-    READ_FILE_BUFFER(psl, pslf);
+    /* load it */
+    psl.buf = pslLoadFile(pslf, &psl.bufused);
     fclose(pslf);
 
     /* get the desired data */
@@ -125,6 +124,11 @@ void psldasm(int indent, size_t sz, unsigned char *psl, FILE *out)
                         (raw[3]));
                 psli++;
 
+            } else if (cmd == psl_raw && (rawsz == 1 || rawsz == 2) && ncmd == psl_integer) {
+                /* shrunk by cplof -O */
+                fprintf(out, "%d\n", (rawsz == 1) ? raw[0] : ((raw[0] << 8) | raw[1]));
+                psli++;
+
             } else {
                 /* output the raw */
                 switch (cmd) {
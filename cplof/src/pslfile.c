@@ -24,10 +24,53 @@
 
 #include <string.h>
 
+#ifdef HAVE_CONFIG_H
+#include "../config.h"
+#else
+#include "basicconfig.h"
+#endif
+
+#ifdef HAVE_UNISTD_H
+#include <sys/stat.h>
+#endif
+
 #include "plof/bignum.h"
 #include "plof/psl.h"
 #include "plof/pslfile.h"
 
+/* load the whole of a file into the (atomic) heap. It's read rather than
+ * mapped: views of it may live anywhere, so it must not change or vanish if
+ * the file is rewritten, and the GC frees it once they're gone */
+unsigned char *pslLoadFile(FILE *fh, size_t *sz)
+{
+    unsigned char *buf;
+    size_t bufsz, rd;
+
+    bufsz = 1024;
+
+#ifdef HAVE_UNISTD_H
+    {
+        struct stat st;
+
+        /* read a plain file in one go, leaving room to notice it growing */
+        if (fstat(fileno(fh), &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0)
+            bufsz = (size_t) st.st_size + 1;
+    }
+#endif
+
+    buf = (unsigned char *) GC_MALLOC_ATOMIC(bufsz);
+    *sz = 0;
+    while ((rd = fread(buf + *sz, 1, bufsz - *sz, fh)) > 0) {
+        *sz += rd;
+        if (*sz == bufsz) {
+            bufsz *= 2;
+            buf = (unsigned char *) GC_REALLOC(buf, bufsz);
+        }
+    }
+
+    return buf;
+}
+
 /* return true if this buffer points to a PSL file */
 int isPSLFile(size_t sz, unsigned char *buf)
 {
@@ -145,20 +188,25 @@ void writePSLFile(FILE *to, size_t sz, unsigned char *buf, unsigned char strippe
     }
 }
 
-/* unstrip PSL */
-struct Buffer_psl unstripPSL(struct Buffer_psl psls, struct Buffer_psl strtab)
-{
-    struct Buffer_psl psl;
-    size_t psli;
+/* Stripped PSL is PSL with the data of raw instructions moved into a table,
+ * each raw instruction being followed by its data's length and location in
+ * the table instead. Code blocks may just be fragments of PSL (the parser
+ * builds code from them), so only those which are whole PSL are stripped. The
+ * data length of code, immediate and marker instructions is given shifted
+ * left one, with the low bit set if the data was stripped */
 
-    INIT_ATOMIC_BUFFER(psl);
+/* unstrip PSL until the end of psls or until psl reaches until bytes */
+static void unstripPSLData(struct Buffer_psl psls, size_t *pslip, struct Buffer_psl strtab,
+                           struct Buffer_psl *psl, size_t until)
+{
+    size_t psli = *pslip;
 
     /* go command-by-command, unstripping as necessary */
-    for (psli = 0; psli < psls.bufused; psli++) {
+    for (; psli < psls.bufused && psl->bufused < until; psli++) {
         unsigned char cmd = psls.buf[psli];
         
         /* write the command ... */
-        WRITE_BUFFER(psl, &cmd, 1);
+        WRITE_BUFFER(*psl, &cmd, 1);
 
         /* if it's raw data, need to handle it specially */
         if (cmd == psl_raw) {
@@ -169,7 +217,7 @@ struct Buffer_psl unstripPSL(struct Buffer_psl psls, struct Buffer_psl strtab)
             blen = pslBignumToInt(psls.buf + psli, &len);
 
             /* and write it */
-            WRITE_BUFFER(psl, psls.buf + psli, blen);
+            WRITE_BUFFER(*psl, psls.buf + psli, blen);
             psli += blen;
 
             /* then write the string */
@@ -178,47 +226,162 @@ struct Buffer_psl unstripPSL(struct Buffer_psl psls, struct Buffer_psl strtab)
             if (loc > strtab.bufused || loc + len > strtab.bufused) {
                 fprintf(stderr, "Error decoding raw data table!\n");
                 for (; len > 0; len--) {
-                    WRITE_BUFFER(psl, &cmd, 1);
+                    WRITE_BUFFER(*psl, &cmd, 1);
                 }
             } else {
-                WRITE_BUFFER(psl, strtab.buf + loc, len);
+                WRITE_BUFFER(*psl, strtab.buf + loc, len);
             }
+
+        } else if (cmd >= psl_marker) {
+            size_t len, blen;
+            psli++;
+
+            /* get the size and whether it was stripped */
+            psli += pslBignumToInt(psls.buf + psli, &len);
+            blen = pslBignumLength(len >> 1);
+            while (BUFFER_SPACE(*psl) < blen) EXPAND_BUFFER(*psl);
+            pslIntToBignum(BUFFER_END(*psl), len >> 1, blen);
+            psl->bufused += blen;
+
+            if (len & 1) {
+                unstripPSLData(psls, &psli, strtab, psl, psl->bufused + (len >> 1));
+                psli--;
+            } else {
+                len >>= 1;
+                if (len > psls.bufused - psli) len = psls.bufused - psli;
+                WRITE_BUFFER(*psl, psls.buf + psli, len);
+                psli += len - 1;
+            }
+
         }
     }
 
+    *pslip = psli;
+}
+
+/* unstrip PSL */
+struct Buffer_psl unstripPSL(struct Buffer_psl psls, struct Buffer_psl strtab)
+{
+    struct Buffer_psl psl;
+    size_t psli = 0;
+
+    INIT_ATOMIC_BUFFER(psl);
+    unstripPSLData(psls, &psli, strtab, &psl, (size_t) -1);
+
     return psl;
 }
 
+/* return true if this is whole PSL */
+int isWholePSL(size_t psllen, unsigned char *psl)
+{
+    size_t psli, len, bi;
+
+    for (psli = 0; psli < psllen; psli++) {
+        if (psl[psli] >= psl_marker) {
+            psli++;
+
+            /* the length must be there */
+            for (bi = psli; bi < psllen && psl[bi] >= 128; bi++);
+            if (bi >= psllen) return 0;
+
+            psli += pslBignumToInt(psl + psli, &len);
+            if (len > psllen - psli) return 0;
+            psli += len - 1;
+        }
+    }
+
+    return 1;
+}
+
+/* return true if this PSL has immediates of its own (not just in code
+ * blocks) */
+int pslHasImmediate(size_t psllen, unsigned char *psl)
+{
+    size_t psli, len;
+    for (psli = 0; psli < psllen; psli++) {
+        if (psl[psli] == psl_immediate) return 1;
+        if (psl[psli] >= psl_marker) {
+            psli++;
+            psli += pslBignumToInt(psl + psli, &len);
+            psli += len - 1;
+        }
+    }
+    return 0;
+}
+
+/* the string table index for stripPSL, a chained hash table of the strings
+ * already in the table */
+struct StripStr {
+    size_t hash, loc, len;
+    struct StripStr *next;
+};
+struct StripIndex {
+    size_t size, count;
+    struct StripStr **buckets;
+};
+
+static size_t stripPSLHash(unsigned char *str, size_t len)
+{
+    size_t i, hash = 2166136261U;
+    for (i = 0; i < len; i++) {
+        hash ^= str[i];
+        hash *= 16777619U;
+    }
+    return hash;
+}
+
 /* write the requested string into the string table, or use it if it's already there */
-static size_t stripPSLStr(unsigned char *str, size_t len, struct Buffer_psl *strtab)
+static size_t stripPSLStr(unsigned char *str, size_t len, struct Buffer_psl *strtab,
+                          struct StripIndex *index)
 {
-    size_t si;
+    size_t hash = stripPSLHash(str, len), i;
+    struct StripStr *cur, *next;
 
     /* first check if it's there */
-    if (strtab->bufused >= len) {
-        for (si = 0; si < strtab->bufused - len; si++) {
-            if (!memcmp(strtab->buf + si, str, len)) return si;
-        }
+    for (cur = index->buckets[hash & (index->size - 1)]; cur; cur = cur->next) {
+        if (cur->hash == hash && cur->len == len &&
+            !memcmp(strtab->buf + cur->loc, str, len))
+            return cur->loc;
     }
 
     /* not there, add it */
-    si = strtab->bufused;
+    cur = GC_NEW(struct StripStr);
+    cur->hash = hash;
+    cur->loc = strtab->bufused;
+    cur->len = len;
     WRITE_BUFFER(*strtab, str, len);
 
-    return si;
+    /* growing the index if it's getting full */
+    if (++index->count > index->size) {
+        struct StripStr **old = index->buckets;
+        size_t oldsize = index->size;
+
+        index->size *= 2;
+        index->buckets = (struct StripStr **) GC_MALLOC(index->size * sizeof(struct StripStr *));
+        for (i = 0; i < oldsize; i++) {
+            for (next = old[i]; next;) {
+                struct StripStr *move = next;
+                next = next->next;
+                move->next = index->buckets[move->hash & (index->size - 1)];
+                index->buckets[move->hash & (index->size - 1)] = move;
+            }
+        }
+    }
+    cur->next = index->buckets[hash & (index->size - 1)];
+    index->buckets[hash & (index->size - 1)] = cur;
+
+    return cur->loc;
 }
 
-/* strip PSL */
-void stripPSL(struct Buffer_psl psl, struct Buffer_psl *psls, struct Buffer_psl *strtab)
+/* strip some (whole) PSL */
+static void stripPSLData(unsigned char *psl, size_t psllen, struct Buffer_psl *psls,
+                         struct Buffer_psl *strtab, struct StripIndex *index)
 {
     size_t psli;
 
-    INIT_ATOMIC_BUFFER(*psls);
-    INIT_ATOMIC_BUFFER(*strtab);
-
     /* go command-by-command, stripping as necessary */
-    for (psli = 0; psli < psl.bufused; psli++) {
-        unsigned char cmd = psl.buf[psli];
+    for (psli = 0; psli < psllen; psli++) {
+        unsigned char cmd = psl[psli];
         
         /* write the command ... */
         WRITE_BUFFER(*psls, &cmd, 1);
@@ -229,14 +392,14 @@ void stripPSL(struct Buffer_psl psl, struct Buffer_psl *psls, struct Buffer_psl
             psli++;
 
             /* get the size ... */
-            blen = pslBignumToInt(psl.buf + psli, &len);
+            blen = pslBignumToInt(psl + psli, &len);
 
             /* and write it */
-            WRITE_BUFFER(*psls, psl.buf + psli, blen);
+            WRITE_BUFFER(*psls, psl + psli, blen);
             psli += blen;
 
             /* then get the string location */
-            loc = stripPSLStr(psl.buf + psli, len, strtab);
+            loc = stripPSLStr(psl + psli, len, strtab, index);
             psli += len - 1;
 
             /* and write it */
@@ -244,6 +407,44 @@ void stripPSL(struct Buffer_psl psl, struct Buffer_psl *psls, struct Buffer_psl
             while (BUFFER_SPACE(*psls) < blen) EXPAND_BUFFER(*psls);
             pslIntToBignum(BUFFER_END(*psls), loc, blen);
             psls->bufused += blen;
+
+        } else if (cmd >= psl_marker) {
+            size_t len, slen, blen;
+            int whole;
+            psli++;
+
+            /* code and immediates are stripped too, if they're whole */
+            psli += pslBignumToInt(psl + psli, &len);
+            whole = (cmd != psl_marker && isWholePSL(len, psl + psli));
+
+            slen = (len << 1) | whole;
+            blen = pslBignumLength(slen);
+            while (BUFFER_SPACE(*psls) < blen) EXPAND_BUFFER(*psls);
+            pslIntToBignum(BUFFER_END(*psls), slen, blen);
+            psls->bufused += blen;
+
+            if (whole) {
+                stripPSLData(psl + psli, len, psls, strtab, index);
+            } else {
+                WRITE_BUFFER(*psls, psl + psli, len);
+            }
+            psli += len - 1;
+
         }
     }
 }
+
+/* strip PSL */
+void stripPSL(struct Buffer_psl psl, struct Buffer_psl *psls, struct Buffer_psl *strtab)
+{
+    struct StripIndex index;
+
+    INIT_ATOMIC_BUFFER(*psls);
+    INIT_ATOMIC_BUFFER(*strtab);
+
+    index.size = 256;
+    index.count = 0;
+    index.buckets = (struct StripStr **) GC_MALLOC(index.size * sizeof(struct StripStr *));
+
+    stripPSLData(psl.buf, psl.bufused, psls, strtab, &index);
+}
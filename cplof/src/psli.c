@@ -23,118 +23,145 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "plof/bignum.h"
+#include "plof/bundle.h"
 #include "plof/memory.h"
 #include "plof/plof.h"
+#include "plof/profile.h"
 #include "plof/psl.h"
+#include "plof/pslfile.h"
 #include "whereami.h"
 
-#define BUFSTEP 1024
+static int runPSLFile(struct PlofObject *context, const char *name, size_t len, unsigned char *file);
 
 int main(int argc, char **argv)
 {
     FILE *pslf;
-    unsigned char *psl;
-    size_t len, rd, i;
-    size_t slen, stype, stl;
+    unsigned char *file;
+    size_t len, i;
     struct PlofObject *context;
-    struct PlofReturn ret;
-    char *wdir, *wfil;
+    char *wdir, *wfil, *exe;
+    int bundled, argn, onIncPath;
 
     GC_INIT();
 
-    if (argc != 2) {
-        fprintf(stderr, "Use: psli <file>\n");
-        return 1;
+    /* we may have a bundle, in which case we run it instead of a file */
+    bundled = 0;
+    if (whereAmI(argv[0], &wdir, &wfil)) {
+        exe = GC_MALLOC_ATOMIC(strlen(wdir) + strlen(wfil) + 2);
+        sprintf(exe, "%s/%s", wdir, wfil);
+        bundled = (plofLoadBundle(exe) > 0);
+    } else {
+        wdir = NULL;
     }
 
-    /* get our search path */
-    if (whereAmI(argv[0], &wdir, &wfil)) {
-        plofIncludePaths = GC_MALLOC(3 * sizeof(unsigned char *));
+    /* get our search path, starting with any -I (a bundle's args are all
+     * its own) */
+    plofIncludePaths = GC_MALLOC((argc + 3) * sizeof(unsigned char *));
+    onIncPath = 0;
+    for (argn = 1; !bundled && argn + 1 < argc && !strcmp(argv[argn], "-I"); argn += 2) {
+        plofIncludePaths[onIncPath] = GC_MALLOC_ATOMIC(strlen(argv[argn+1]) + 2);
+        sprintf((char *) plofIncludePaths[onIncPath++], "%s/", argv[argn+1]);
+    }
 
+    if (wdir) {
         /* /../share/plof_include/ */
-        plofIncludePaths[0] = GC_MALLOC_ATOMIC(strlen(wdir) + 24);
-        sprintf((char *) plofIncludePaths[0], "%s/../share/plof_include/", wdir);
+        plofIncludePaths[onIncPath] = GC_MALLOC_ATOMIC(strlen(wdir) + 24);
+        sprintf((char *) plofIncludePaths[onIncPath++], "%s/../share/plof_include/", wdir);
 
-        /* /../../plof_include/ (for running from src/) */
-        plofIncludePaths[1] = GC_MALLOC_ATOMIC(strlen(wdir) + 21);
-        sprintf((char *) plofIncludePaths[1], "%s/../../plof_include/", wdir);
-
-        plofIncludePaths[2] = NULL;
+        /* /../../plofcore/ (for running from src/) */
+        plofIncludePaths[onIncPath] = GC_MALLOC_ATOMIC(strlen(wdir) + 17);
+        sprintf((char *) plofIncludePaths[onIncPath++], "%s/../../plofcore/", wdir);
+    }
 
-        /* FIXME: should support -I eventually */
+    plofIncludePaths[onIncPath] = NULL;
 
-    } else {
-        plofIncludePaths[0] = NULL;
+    if (!bundled && argn >= argc) {
+        fprintf(stderr, "Use: psli [-I <dir>]... <file> [args]\n");
+        return 1;
+    }
 
+    /* PLOF_PROFILE=<file> profiles the run, as cplof --profile */
+    if (getenv("PLOF_PROFILE")) {
+        if (!plofProfileStart(getenv("PLOF_PROFILE")))
+            return 1;
+        atexit(plofProfileStop);
     }
 
-    /* open the file */
-    pslf = fopen(argv[1], "rb");
-    if (pslf == NULL) {
-        perror(argv[1]);
-        return 1;
+    /* PLOF_COUNT_OPS=1 counts instructions and calls, as cplof --count-ops */
+    if (getenv("PLOF_COUNT_OPS")) {
+        plofCountOps = 1;
+        atexit(plofCountReport);
     }
 
-    /* preallocate the buffer */
-    psl = GC_MALLOC_ATOMIC(BUFSTEP);
-    len = 0;
+    /* Initialize null and global */
+    plofNull = newPlofObject();
+    plofNull->parent = plofNull;
+    plofGlobal = newPlofObject();
+    plofGlobal->parent = plofGlobal;
 
-    /* now start reading */
-    while ((rd = fread(psl + len, 1, BUFSTEP, pslf))) {
-        len += rd;
-        if (rd < BUFSTEP) break;
+    /* And the context */
+    context = newPlofObject();
+    context->parent = plofNull;
 
-        /* allocate more */
-        psl = GC_REALLOC(psl, len + BUFSTEP);
+    if (bundled) {
+        /* run each of the bundle's programs, in order */
+        plofSetArgs(plofGlobal, (unsigned char *) "args", argc - 1, argv + 1);
+        for (i = 0; i < plofBundleFileCount; i++) {
+            struct PlofBundleFile *f = &plofBundleFiles[i];
+            if (f->run && runPSLFile(context, exe, f->length, f->data))
+                return 1;
+        }
+        return 0;
     }
-    fclose(pslf);
 
-    /* FIXME: bounds checking */
+    /* open the file */
+    pslf = fopen(argv[argn], "rb");
+    if (pslf == NULL) {
+        perror(argv[argn]);
+        return 1;
+    }
 
-    /* Go section-by-section */
-    for (i = 8; i < len;) {
-        /* section length */
-        i += pslBignumToInt(psl + i, (size_t *) &slen);
+    /* load it */
+    file = pslLoadFile(pslf, &len);
+    fclose(pslf);
 
-        /* section type */
-        stl = pslBignumToInt(psl + i, (size_t *) &stype);
+    plofSetArgs(plofGlobal, (unsigned char *) "args", argc - argn - 1, argv + argn + 1);
+    return runPSLFile(context, argv[argn], len, file);
+}
 
-        /* if it's program data, we found it */
-        if (stype == 0) {
-            i += stl;
-            break;
+/* run a PSL file, returning 1 if it fails */
+static int runPSLFile(struct PlofObject *context, const char *name, size_t len, unsigned char *file)
+{
+    struct Buffer_psl psl;
+    struct PlofObject *pslobj;
+    struct PlofReturn ret;
 
-        } else {
-            /* skip this section */
-            i += slen;
-        }
+    if (!isPSLFile(len, file)) {
+        fprintf(stderr, "%s is not a PSL file!\n", name);
+        return 1;
     }
+    psl = readPSLFile(len, file);
 
     /* make sure we found it */
-    if (i >= len) {
-        fprintf(stderr, "No program data!\n");
+    if (psl.buf == NULL) {
         return 1;
     }
 
-    /* Initialize null and global */
-    plofNull = newPlofObject();
-    plofNull->parent = plofNull;
-    plofGlobal = newPlofObject();
-    plofGlobal->parent = plofGlobal;
-
-    /* And the context */
-    context = newPlofObject();
-    context->parent = plofNull;
+    /* interpret it in place, so that its data are views of the file */
+    pslobj = newPlofObject();
+    pslobj->parent = plofNull;
+    pslobj->data = (struct PlofData *) newPlofRawDataView(psl.bufused, psl.buf);
 
     /* Now interp */
-    interpretPSL(context, plofNull, NULL, slen - stl, psl + i, 0, 1);
-    ret = interpretPSL(context, plofNull, NULL, slen - stl, psl + i, 0, 0);
+    interpretPSL(context, plofNull, pslobj, 0, NULL, 0, 1);
+    ret = interpretPSL(context, plofNull, pslobj, 0, NULL, 0, 0);
 
     if (ret.isThrown) {
-        fprintf(stderr, "PSL threw up!\n");
+        plofThrewUp(ret.ret);
         return 1;
     }
 
@@ -0,0 +1,218 @@
+/*
+ * PSL-to-PSL optimizer
+ *
+ * Copyright (C) 2010 Gregor Richards
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <string.h>
+
+#include "plof/bignum.h"
+#include "plof/memory.h"
+#include "plof/psl.h"
+#include "plof/pslfile.h"
+#include "pslopt.h"
+
+/* an instruction being optimized */
+struct PSLOptInst {
+    unsigned char cmd;
+    unsigned char *data;
+    size_t datasz;
+};
+BUFFER(PSLOptInst, struct PSLOptInst);
+
+/* integer literals are only folded within this range, in which they mean the
+ * same whatever the word size */
+#define PSLOPT_INT_MAX ((size_t) 1 << 30)
+
+/* get the value of a raw integer literal, returning 0 if it isn't one that
+ * can be folded */
+static int optIntValue(struct PSLOptInst *raw, size_t *val)
+{
+    size_t i;
+
+    if (raw->cmd != psl_raw ||
+        (raw->datasz != 1 && raw->datasz != 2 && raw->datasz != 4)) return 0;
+
+    *val = 0;
+    for (i = 0; i < raw->datasz; i++)
+        *val = (*val << 8) | raw->data[i];
+    return (*val < PSLOPT_INT_MAX);
+}
+
+/* make a raw integer literal, as small as possible */
+static void optIntRaw(struct PSLOptInst *raw, size_t val)
+{
+    size_t i;
+
+    raw->cmd = psl_raw;
+    raw->datasz = (val < 0x100) ? 1 : (val < 0x10000) ? 2 : 4;
+    raw->data = (unsigned char *) GC_MALLOC_ATOMIC(raw->datasz);
+    for (i = raw->datasz; i > 0; i--) {
+        raw->data[i-1] = val & 0xFF;
+        val >>= 8;
+    }
+}
+
+/* fold an integer operation, returning 0 if it can't be */
+static int optFold(unsigned char cmd, size_t a, size_t b, size_t *res)
+{
+    switch (cmd) {
+        case psl_add: *res = a + b; break;
+        case psl_sub: if (b > a) return 0; *res = a - b; break;
+        case psl_mul: if (a && b >= PSLOPT_INT_MAX / a) return 0; *res = a * b; break;
+        case psl_div: if (b == 0) return 0; *res = a / b; break;
+        case psl_mod: if (b == 0) return 0; *res = a % b; break;
+        case psl_sl:
+            /* a << b could wrap around a 32-bit size_t back into range */
+            if (b >= 30 || a > (PSLOPT_INT_MAX - 1) >> b) return 0;
+            *res = a << b;
+            break;
+        case psl_sr: *res = (b >= 30) ? 0 : a >> b; break;
+        case psl_or: *res = a | b; break;
+        case psl_xor: *res = a ^ b; break;
+        case psl_and: *res = a & b; break;
+        default: return 0;
+    }
+    return (*res < PSLOPT_INT_MAX);
+}
+
+/* does this instruction just push something? */
+static int optIsPush(unsigned char cmd)
+{
+    return (cmd <= psl_push7 || cmd == psl_this || cmd == psl_null || cmd == psl_global ||
+            cmd == psl_code || cmd == psl_raw);
+}
+
+/* whether the objects two instructions push are the same (1), different (0)
+ * or unknown (-1) */
+static int optSameObject(unsigned char a, unsigned char b)
+{
+    int aknown = (a == psl_null || a == psl_global);
+    int bknown = (b == psl_null || b == psl_global);
+    int anew = (a == psl_raw || a == psl_code);
+    int bnew = (b == psl_raw || b == psl_code);
+
+    if (aknown && bknown) return (a == b);
+    if ((aknown && bnew) || (anew && bknown)) return 0;
+    return -1;
+}
+
+/* add an instruction, optimizing the end of what we have so far */
+static void optAdd(struct Buffer_PSLOptInst *out, struct PSLOptInst *inst)
+{
+    struct PSLOptInst *top;
+    size_t a, b, res;
+    int same;
+
+    WRITE_BUFFER(*out, inst, 1);
+    top = BUFFER_END(*out) - 1;
+
+    switch (inst->cmd) {
+        case psl_integer:
+            /* shrink integer literals */
+            if (out->bufused >= 2 && optIntValue(top - 1, &a))
+                optIntRaw(top - 1, a);
+            break;
+
+        case psl_pop:
+            /* don't push what's just going to be popped */
+            if (out->bufused >= 2 && optIsPush(top[-1].cmd)) {
+                out->bufused -= 2;
+            } else if (out->bufused >= 3 && top[-1].cmd == psl_integer &&
+                       optIntValue(top - 2, &a)) {
+                out->bufused -= 3;
+            }
+            break;
+
+        case psl_cmp:
+            /* <a> <b> <c> <d> <e> cmp is <a> <d> call or <a> <e> call when we
+             * know whether b and c are the same */
+            if (out->bufused >= 5 && top[-1].cmd == psl_code && top[-2].cmd == psl_code &&
+                (same = optSameObject(top[-4].cmd, top[-3].cmd)) != -1) {
+                top[-4] = same ? top[-2] : top[-1];
+                top[-3].cmd = psl_call;
+                out->bufused -= 3;
+            }
+            break;
+
+        default:
+            /* fold integer operations on literals */
+            if (out->bufused >= 5 &&
+                top[-1].cmd == psl_integer && optIntValue(top - 2, &b) &&
+                top[-3].cmd == psl_integer && optIntValue(top - 4, &a) &&
+                optFold(inst->cmd, a, b, &res)) {
+                optIntRaw(top - 4, res);
+                top[-3].cmd = psl_integer;
+                out->bufused -= 3;
+            }
+    }
+}
+
+/* optimize PSL */
+struct Buffer_psl optimizePSL(unsigned char *psl, size_t psllen)
+{
+    struct Buffer_PSLOptInst insts;
+    struct PSLOptInst inst;
+    struct Buffer_psl ret, sub;
+    size_t psli, i, blen;
+
+    INIT_BUFFER(insts);
+
+    for (psli = 0; psli < psllen; psli++) {
+        inst.cmd = psl[psli];
+        inst.data = NULL;
+        inst.datasz = 0;
+
+        if (inst.cmd >= psl_marker) {
+            psli++;
+            psli += pslBignumToInt(psl + psli, &inst.datasz);
+            inst.data = psl + psli;
+            psli += inst.datasz - 1;
+
+            /* optimize code too, if it's whole */
+            if ((inst.cmd == psl_code || inst.cmd == psl_immediate) &&
+                isWholePSL(inst.datasz, inst.data)) {
+                sub = optimizePSL(inst.data, inst.datasz);
+                inst.data = sub.buf;
+                inst.datasz = sub.bufused;
+            }
+        }
+
+        optAdd(&insts, &inst);
+    }
+
+    /* then write it back out */
+    INIT_ATOMIC_BUFFER(ret);
+    for (i = 0; i < insts.bufused; i++) {
+        struct PSLOptInst *cur = &insts.buf[i];
+        WRITE_BUFFER(ret, &cur->cmd, 1);
+        if (cur->cmd >= psl_marker) {
+            blen = pslBignumLength(cur->datasz);
+            while (BUFFER_SPACE(ret) < blen) EXPAND_BUFFER(ret);
+            pslIntToBignum(BUFFER_END(ret), cur->datasz, blen);
+            STEP_BUFFER(ret, blen);
+            WRITE_BUFFER(ret, cur->data, cur->datasz);
+        }
+    }
+
+    return ret;
+}